@@ -1,4 +1,5 @@
 #include "bloom_filter.h"
+#include <chrono>
 #include <cmath>
 #include <functional>
 #include <set>
@@ -10,10 +11,18 @@
 const IbfCell kDefaultCell = {0, 0, 0};
 
 // Methods
-InvBloom::InvBloom(uint32_t d, uint32_t k, float alpha, float query_threshold) {
+InvBloom::InvBloom(uint32_t d, uint32_t k, float alpha, float query_threshold,
+                   uint32_t fold_levels, uint32_t seed) {
   this->n = (uint32_t) ceil(d*alpha);
   this->k = k;
   this->query_threshold = query_threshold;
+  this->partitioned = fold_levels > 0;
+  this->seed = seed;
+  this->version = 0;
+  if (this->partitioned) {
+    uint32_t multiple = k << fold_levels;
+    this->n = (this->n + multiple - 1) / multiple * multiple;
+  }
   this->table.resize(n, kDefaultCell);  
 } 
 
@@ -23,53 +32,184 @@ InvBloom::~InvBloom() {
 // Encode the set as an invertible bloom filter and store the
 // result in this.
 void InvBloom::encode(const std::vector<uint64_t> &set) {
-//  std::cout << "encode (k=" << this->k << ")\n";
-  int idxs[this->k]; // init to 0 
   for (uint64_t s_i : set) {
-    encodeHash(s_i, idxs);
-/*    std::cout << "idxs for " << s_i << ": ";
-    for (int t = 0; t < this->k; t++) { 
-      std::cout << idxs[t] << ",";
-    }
-    std::cout << "\n";
-*/
-    for (int j : idxs) {
-      // bounds check
-      if (j < 0 || j >= this->n) { continue; } // TODO raise error 
-      // todo check that indices are distinct
-      // using bitwise xor; TODO correct?
-/*      if (j==14) {
-        std::cout << "idSum: " << this->table[j].idSum << "\n";
-        std::cout << "var idSum: " << idSum << "\n";
-        std::cout << "s_i: " << s_i << "\n";
-        std::cout << "xor: " << (idSum ^ s_i) << "\n";
-      }
-*/
-      this->table[j].idSum ^= s_i;
-      this->table[j].hashSum ^= checksumHash(s_i);
-      this->table[j].count++; 
-    }
+    insert(s_i);
   }
 //  fprintf(stdout, "Encode result:\n%s", this->to_string().c_str());
 }
 
+// Add a single element to this IBF.
+void InvBloom::insert(const uint64_t elt) {
+  int idxs[this->k]; // init to 0 
+  encodeHash(elt, idxs);
+  uint32_t hs = checksumHash(elt);
+  for (int j : idxs) {
+    // bounds check
+    if (j < 0 || j >= this->n) { continue; } // TODO raise error 
+    this->table[j].idSum ^= elt;
+    this->table[j].hashSum ^= hs;
+    this->table[j].count++; 
+    touch(j);
+  }
+}
+
+// Reset every cell to zero, keeping n, k and the hashing mode.
+void InvBloom::clear() {
+  for (int i = 0; i < this->n; i++) {
+    this->table[i] = kDefaultCell;
+    touch(i);
+  }
+}
+
 // Subtract IBF "other" from this IBF and store the result in
 // result.
 // Precondition: this, other, and result have the same k and n.
 // TODO for subtract and subtract_cell, should I just overwrite
 // this with result instead of making a new IBF?
 bool InvBloom::subtract(const InvBloom &other, InvBloom *result) {
-  if (other.k != this->k || result->k != this->k) {
+  if (!compatible(other, *result)) { return false; }
+  for (int i = 0; i < this->n; i++) {
+    subtractCell(i, other.table[i], &result->table[i]);
+    result->touch(i);
+  }
+  return true;
+}
+
+// Add IBF "other" to this IBF and store the result in result.
+// Precondition: this, other, and result have the same k and n.
+bool InvBloom::add(const InvBloom &other, InvBloom *result) {
+  if (!compatible(other, *result)) { return false; }
+  for (int i = 0; i < this->n; i++) {
+    result->table[i].idSum = this->table[i].idSum ^ other.table[i].idSum;
+    result->table[i].hashSum = this->table[i].hashSum ^ other.table[i].hashSum;
+    result->table[i].count = this->table[i].count + other.table[i].count;
+    result->touch(i);
+  }
+  return true;
+}
+
+// Return true if other and result can be combined cell by cell
+// with this IBF; print the mismatch otherwise.
+bool InvBloom::compatible(const InvBloom &other, const InvBloom &result) {
+  if (other.k != this->k || result.k != this->k) {
     std::cerr << "this IBF, other, and result must all be initialized with same k\n";
     return false;    
   }
-  if (other.n != this->n || result->n != this->n) {
+  if (other.n != this->n || result.n != this->n) {
      std::cerr << "this IBF, other, and result must all be initialized with same n\n";
     return false;
   }
+  if (other.partitioned != this->partitioned || result.partitioned != this->partitioned) {
+    std::cerr << "this IBF, other, and result must all be foldable or not\n";
+    return false;
+  }
+  if (other.seed != this->seed || result.seed != this->seed) {
+    std::cerr << "this IBF, other, and result must all be initialized with same seed\n";
+    return false;
+  }
+  return true;
+}
+
+// Fold this (foldable) IBF into one with n/factor cells and store
+// the result in result.
+bool InvBloom::fold(uint32_t factor, InvBloom *result) {
+  if (!this->partitioned) {
+    std::cerr << "only IBFs constructed with fold_levels > 0 can be folded\n";
+    return false;
+  }
+  uint32_t sub = this->n / this->k;
+  if (factor == 0 || sub % factor != 0) {
+    std::cerr << "fold factor must divide the sub-table size " << sub << "\n";
+    return false;
+  }
+  uint32_t folded_sub = sub / factor;
+  // Fold into a scratch table so that result may alias this.
+  std::vector<IbfCell> folded(folded_sub * this->k, kDefaultCell);
   for (int i = 0; i < this->n; i++) {
-    subtractCell(i, other.table[i], &result->table[i]);
+    IbfCell &cell = folded[(i / sub) * folded_sub + (i % sub) % folded_sub];
+    cell.count += this->table[i].count;
+    cell.idSum ^= this->table[i].idSum;
+    cell.hashSum ^= this->table[i].hashSum;
+  }
+  result->n = folded_sub * this->k;
+  result->k = this->k;
+  result->query_threshold = this->query_threshold;
+  result->partitioned = true;
+  result->seed = this->seed;
+  result->table.swap(folded);
+  result->cell_versions.clear();
+  return true;
+}
+
+// Start recording the version in which each cell last changed.
+void InvBloom::trackChanges() {
+  this->version = 1;
+  this->cell_versions.assign(this->n, 0);
+  for (int i = 0; i < this->n; i++) {
+    if (isNonzero(i)) { this->cell_versions[i] = this->version; }
   }
+}
+
+// Store in delta every cell that changed after version "since" and
+// start a new version.
+bool InvBloom::emitDelta(uint32_t since, IbfDelta *delta) {
+  if (this->cell_versions.empty()) {
+    std::cerr << "emitDelta requires trackChanges\n";
+    return false;
+  }
+  if (since >= this->version) {
+    std::cerr << "version " << since << " has not been emitted yet\n";
+    return false;
+  }
+  delta->n = this->n;
+  delta->k = this->k;
+  delta->partitioned = this->partitioned;
+  delta->seed = this->seed;
+  delta->since = since;
+  delta->version = this->version;
+  delta->idxs.clear();
+  delta->cells.clear();
+  for (int i = 0; i < this->n; i++) {
+    if (this->cell_versions[i] > since) {
+      delta->idxs.push_back(i);
+      delta->cells.push_back(this->table[i]);
+    }
+  }
+  this->version++;
+  return true;
+}
+
+// Apply a delta emitted by the IBF this one mirrors.
+bool InvBloom::applyDelta(const IbfDelta &delta, uint32_t *mirror_version) {
+  if (delta.n != this->n || delta.k != this->k) {
+    std::cerr << "delta must come from an IBF with the same n and k\n";
+    return false;
+  }
+  if (delta.partitioned != this->partitioned || delta.seed != this->seed) {
+    std::cerr << "delta must come from an IBF with the same hashing mode and seed\n";
+    return false;
+  }
+  if (delta.cells.size() != delta.idxs.size()) {
+    std::cerr << "delta has " << delta.idxs.size() << " indices but " \
+              << delta.cells.size() << " cells\n";
+    return false;
+  }
+  if (delta.since != *mirror_version) {
+    std::cerr << "delta is since version " << delta.since << " but mirror is at " \
+              << *mirror_version << "\n";
+    return false;
+  }
+  for (int i = 0; i < delta.idxs.size(); i++) {
+    if (delta.idxs[i] >= this->n) {
+      std::cerr << "delta cell index out of range\n";
+      return false;
+    }
+  }
+  for (int i = 0; i < delta.idxs.size(); i++) {
+    this->table[delta.idxs[i]] = delta.cells[i];
+    touch(delta.idxs[i]);
+  }
+  *mirror_version = delta.version;
   return true;
 }
 
@@ -79,60 +219,140 @@ bool InvBloom::subtract(const InvBloom &other, InvBloom *result) {
 // missingA: list of elements that B contains but A doesn't.
 // Returns true if decoded successfully, false otherwise.
 bool InvBloom::decode(std::vector<uint64_t> *missingB, std::vector<uint64_t> *missingA) {
-  // Find pure elements
-  std::vector<int> pure_idxs;
-  
-  for (int i = 0; i < this->n; i++) {
-    if (isPure(i)) { 
-      pure_idxs.push_back(i); 
-//      std::cout << i << "\n";
-    } 
-  }
+  DecodeState state;
+  DecodeStatus status = decode([&](uint64_t key, int side) {
+    // Add to appropriate set difference list
+    if (side > 0) {
+      missingB->push_back(key);
+    } else {
+      missingA->push_back(key);
+    }
+    return true;
+  }, &state);
+  return status == kDecodeSuccess;
+} 
 
-  int distinct_idxs[this->k]; // holds distinct idxs for given elt
+// Streaming decode: pass each recovered key to sink as it is peeled,
+// within budget. Resumable through state.
+DecodeStatus InvBloom::decode(const DecodeSink &sink, DecodeState *state,
+                              const DecodeBudget &budget) {
+  auto begin = std::chrono::steady_clock::now();
+  if (!state->started) {
+    // Find pure elements and count nonzero cells.
+    state->started = true;
+    state->pure_idxs.clear();
+    state->nonzero = 0;
+    for (int i = 0; i < this->n; i++) {
+      if (isNonzero(i)) { state->nonzero++; }
+      if (isPure(i)) { state->pure_idxs.push_back(i); }
+    }
+  }
 
-  while (pure_idxs.size() > 0) {
-    int i = pure_idxs.back();
-    pure_idxs.pop_back();
+  uint64_t peels = 0;
+  uint64_t steps = 0;
+  while (state->pure_idxs.size() > 0 && state->nonzero > 0) {
+    // Check the budget only after a real peel, so every call makes
+    // progress and an empty IBF is never reported as exhausted.
+    if (peels > 0) {
+      if (budget.max_peels != 0 && peels >= budget.max_peels) {
+        return kDecodeBudgetExhausted;
+      }
+      // Reading the clock costs about as much as a peel; only check
+      // it every 64 steps.
+      if (budget.max_ms != 0 && steps++ % 64 == 0) {
+        std::chrono::duration<double, std::milli> elapsed = \
+          std::chrono::steady_clock::now() - begin;
+        if (elapsed.count() >= budget.max_ms) { return kDecodeBudgetExhausted; }
+      }
+    }
+    int i = state->pure_idxs.back();
+    state->pure_idxs.pop_back();
     // Confirm elt at i is still pure.
     if (!isPure(i)) { continue; }
-    // Add to appropriate set difference list
-//    std::cout << "pure: " << i << "\n";
     int c = this->table[i].count;
     uint64_t ids = this->table[i].idSum;
-//    std::cout << "c: " << c << " idSum: " << ids << "\n";
-    if (c > 0) { 
-//      fprintf(stdout, "Adding to missingB\n");
-      missingB->push_back(ids);
-//      fprintf(stdout, "Added to missingB\n");
-    } else {
-      missingA->push_back(ids);
+    // Remove this element from IBF and update any new pure cells
+    // before handing it out, so a cancelled decode can resume.
+    peel(ids, c, &state->pure_idxs, &state->nonzero);
+    peels++;
+    if (!sink(ids, c > 0 ? 1 : -1)) { return kDecodeCancelled; }
+  }
+
+  // No pure indices remain; the IBF decoded iff all cells are 0.
+  return state->nonzero == 0 ? kDecodeSuccess : kDecodeFailure;
+}
+
+// Decode several IBFs of the same set difference together; elements
+// peeled from any IBF are removed from all of them.
+bool InvBloom::jointDecode(const std::vector<InvBloom*> &ibfs,
+                           std::vector<uint64_t> *missingB,
+                           std::vector<uint64_t> *missingA) {
+  std::vector<std::vector<int>> pure_idxs(ibfs.size());
+  for (int f = 0; f < ibfs.size(); f++) {
+    for (int i = 0; i < ibfs[f]->n; i++) {
+      if (ibfs[f]->isPure(i)) { pure_idxs[f].push_back(i); }
     }
-//    fprintf(stdout, "Added to vector\n");
-    // Remove this element from IBF and update
-    // any new pure cells.
-    encodeHash(ids, distinct_idxs);
-/*    for (int k : distinct_idxs) {
-      std::cout << k;
+  }
+
+  bool remaining = true;
+  while (remaining) {
+    for (int f = 0; f < ibfs.size(); f++) {
+      while (pure_idxs[f].size() > 0) {
+        int i = pure_idxs[f].back();
+        pure_idxs[f].pop_back();
+        if (!ibfs[f]->isPure(i)) { continue; }
+        int c = ibfs[f]->table[i].count;
+        uint64_t ids = ibfs[f]->table[i].idSum;
+        if (c > 0) {
+          missingB->push_back(ids);
+        } else {
+          missingA->push_back(ids);
+        }
+        for (int g = 0; g < ibfs.size(); g++) {
+          ibfs[g]->peel(ids, c, &pure_idxs[g]);
+        }
+      }
     }
-    std::cout << "\n";
-*/
-    for (int j : distinct_idxs) {
-      this->table[j].count -= c;
-      this->table[j].hashSum = this->table[j].hashSum ^ checksumHash(ids);
-      this->table[j].idSum = this->table[j].idSum ^ ids;
-      if (isPure(j)) { pure_idxs.push_back(j); }
+    // Peeling later IBFs may have freed cells in earlier ones.
+    remaining = false;
+    for (int f = 0; f < ibfs.size(); f++) {
+      if (pure_idxs[f].size() > 0) { remaining = true; }
     }
   }
 
-  // No pure indices remain; check that all fields in IBF are 0.
+  bool success = true;
+  for (int f = 0; f < ibfs.size(); f++) {
+    if (!ibfs[f]->isEmpty()) { success = false; }
+  }
+  return success;
+}
+
+// Remove elt, which contributes count c to each of its cells, from
+// this IBF and add any cells that became pure to pure_idxs.
+void InvBloom::peel(const uint64_t &elt, int c, std::vector<int> *pure_idxs,
+                    uint32_t *nonzero) {
+  int distinct_idxs[this->k]; // holds distinct idxs for given elt
+  encodeHash(elt, distinct_idxs);
+  uint32_t hs = checksumHash(elt);
+  for (int j : distinct_idxs) {
+    if (nonzero != nullptr && isNonzero(j)) { (*nonzero)--; }
+    this->table[j].count -= c;
+    this->table[j].hashSum = this->table[j].hashSum ^ hs;
+    this->table[j].idSum = this->table[j].idSum ^ elt;
+    touch(j);
+    if (nonzero != nullptr && isNonzero(j)) { (*nonzero)++; }
+    if (isPure(j)) { pure_idxs->push_back(j); }
+  }
+}
+
+bool InvBloom::isEmpty() {
   for (int i = 0; i < this->n; i++) {
     if (this->table[i].count != 0) { return false; }
     if (this->table[i].hashSum != 0) { return false; }
     if (this->table[i].idSum != 0) { return false; }
   }
   return true;
-} 
+}
 
 bool InvBloom::isPure(int idx) {
   int c = this->table[idx].count;
@@ -175,18 +395,43 @@ uint32_t InvBloom::checksumHash(const uint64_t &elt) {
   return hash_elt(std::to_string(elt)+"checksum");
 }
 
+// First index hash of elt.
+std::size_t InvBloom::indexHash(const uint64_t &elt, uint32_t seed) {
+  std::hash<std::string> hash_elt;
+  // currently doing a hacky thing to get hash values to be different;
+  // should probably be a cryptographic hash function
+  std::string key = std::to_string(elt);
+  // Seed 0 keeps the original (unsalted) index hash.
+  if (seed != 0) { key += "seed" + std::to_string(seed); }
+  return hash_elt(key);
+}
+
+// Next index hash in the chain started by indexHash.
+std::size_t InvBloom::nextIndexHash(std::size_t prev_hash) {
+  std::hash<std::string> hash_elt;
+  return hash_elt(std::to_string(prev_hash));
+}
+
 // Populate "indices" (size of array is k) with computed indices
 // resulting from executing hash function.
 void InvBloom::encodeHash(const uint64_t &elt, int indices[]) {
   std::set<int> idxs;
-  std::hash<std::string> hash_elt;
-  // currently doing a hacky thing to get hash values to be different;
-  // should probably be a cryptographic hash function
-  std::size_t prev_hash = hash_elt(std::to_string(elt));
+  std::size_t prev_hash = indexHash(elt, this->seed);
+  if (this->partitioned) {
+    // One index per sub-table. Reducing the hash modulo the sub-table
+    // size keeps indices consistent across folds, since a folded
+    // sub-table size always divides the original one.
+    uint32_t sub = this->n / this->k;
+    for (int i = 0; i < this->k; i++) {
+      indices[i] = i*sub + prev_hash % sub;
+      prev_hash = nextIndexHash(prev_hash);
+    }
+    return;
+  }
   while (idxs.size() < this->k) {
 //    fprintf(stdout, "n: %d, k: %d, # idxs: %d, prev_hash: %d, idx: %d\n", this->n, this->k, idxs.size(), prev_hash, prev_hash % this->n);
     idxs.insert(prev_hash % this->n);
-    prev_hash = hash_elt(std::to_string(prev_hash));
+    prev_hash = nextIndexHash(prev_hash);
   }
   int count = 0;
   for (int i : idxs) {
@@ -1,4 +1,8 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
 #include <stdint.h>
+#include <functional>
 #include <vector>
 #include <string>
 
@@ -8,16 +12,67 @@ struct IbfCell {
   uint32_t hashSum; // is 4 bytes enough?
 };
 
+// Cells of an InvBloom that changed between two versions; see
+// InvBloom::emitDelta.
+struct IbfDelta {
+  uint32_t n; // layout of the IBF the delta was taken from
+  uint32_t k;
+  bool partitioned;
+  uint32_t seed;
+  uint32_t since; // version the receiving mirror must be at
+  uint32_t version; // version the mirror is at after applying
+  std::vector<uint32_t> idxs; // indices of changed cells
+  std::vector<IbfCell> cells; // new contents of those cells
+};
+
+// Receives each key recovered by the streaming decode as soon as it
+// is peeled. side is 1 if A contains the key but B doesn't (missingB
+// in the vector decode) and -1 otherwise (missingA). Return false to
+// cancel decoding.
+typedef std::function<bool(uint64_t key, int side)> DecodeSink;
+
+// Outcome of a streaming decode call.
+enum DecodeStatus {
+  kDecodeSuccess,  // every key recovered, IBF is empty
+  kDecodeFailure,  // no pure cells left but IBF is not empty
+  kDecodeBudgetExhausted, // stopped at the budget; call again to resume
+  kDecodeCancelled // sink returned false; call again to resume
+};
+
+// Limits for one streaming decode call; 0 means unlimited.
+struct DecodeBudget {
+  uint64_t max_peels; // keys to recover in this call
+  double max_ms; // wall-clock time for this call
+};
+
+// Progress of a streaming decode, kept between calls so that a
+// stopped decode can resume. Use a fresh DecodeState per IBF.
+struct DecodeState {
+  DecodeState() : started(false), nonzero(0) {}
+  bool started;
+  std::vector<int> pure_idxs; // cells that may be pure
+  uint32_t nonzero; // cells with any nonzero field
+};
+
 class InvBloom {
   public:
     uint32_t n; // number of cells; set to d*alpha
     uint32_t k; // number of hash functions
     float query_threshold; 
+    // true if each hash function owns a sub-table of n/k cells
+    // (foldable mode); false if indices range over the whole table.
+    bool partitioned;
+    // Salt for the index hash; IBFs of the same set with different
+    // seeds place elements in independent cells.
+    uint32_t seed;
     std::vector<IbfCell> table; // array of cells
 
     // Constructor: takes desired number of cells and # hash fns.
     // Precondition: k < d*alpha
-    InvBloom(uint32_t d, uint32_t k, float alpha=1.5, float query_threshold=1); 
+    // If fold_levels > 0, the IBF is foldable: n is rounded up to a
+    // multiple of k*2^fold_levels so it can be halved fold_levels times.
+    InvBloom(uint32_t d, uint32_t k, float alpha=1.5, float query_threshold=1,
+             uint32_t fold_levels=0, uint32_t seed=0); 
  
     // Class destructor
     ~InvBloom();
@@ -26,12 +81,51 @@ class InvBloom {
     // result in this.
     void encode(const std::vector<uint64_t> &set);
 
+    // Add a single element to this IBF.
+    void insert(const uint64_t elt);
+
+    // Reset every cell to zero, keeping n, k and the hashing mode.
+    void clear();
+
     // Subtract IBF "other" from this IBF and store the result in
     // result.
     // TODO for subtract and subtract_cell, should I just overwrite
     // this with result instead of making a new IBF?
     bool subtract(const InvBloom &other, InvBloom *result);
 
+    // Add IBF "other" to this IBF and store the result in result
+    // (which may be this). The result encodes the multiset union.
+    bool add(const InvBloom &other, InvBloom *result);
+
+    // Fold this (foldable) IBF into one with n/factor cells and store
+    // the result in result, which is resized as needed. Cell i of each
+    // sub-table is merged into cell i % (n/(k*factor)), so the result
+    // decodes like an IBF encoded directly at the smaller size.
+    // Change tracking is not carried over to the result.
+    // Returns false if this IBF is not foldable or factor does not
+    // divide the sub-table size.
+    bool fold(uint32_t factor, InvBloom *result);
+
+    // Start recording, per cell, the version in which it last changed
+    // (all later mutations through this class are recorded; writes to
+    // table from outside are not). Nonzero cells count as changed
+    // since version 0, so a freshly constructed mirror can be synced
+    // from since = 0.
+    void trackChanges();
+
+    // Store in delta the contents of every cell that changed after
+    // version "since" (0 or a delta->version returned earlier), then
+    // start a new version. Returns false if change tracking is off or
+    // since is a version that has not been emitted yet.
+    bool emitDelta(uint32_t since, IbfDelta *delta);
+
+    // Apply a delta to this IBF, a mirror of the IBF it came from.
+    // *mirror_version is the version the mirror is at (0 when new);
+    // it must equal delta.since and is advanced to delta.version.
+    // Returns false, leaving the mirror unchanged, on a mismatch; the
+    // sender should then emit a delta since *mirror_version instead.
+    bool applyDelta(const IbfDelta &delta, uint32_t *mirror_version);
+
     // Decode this IBF. 
     // missingB: list of elements that A contains but B doesn't.
     // missingA: list of elements that B contains but A doesn't.
@@ -42,6 +136,26 @@ class InvBloom {
     // Returns true if decoded successfully, false otherwise.
     bool decode(std::vector<uint64_t> *missingB, std::vector<uint64_t> *missingA); 
 
+    // Streaming decode: pass each recovered key to sink as it is
+    // peeled, stopping early when budget runs out or sink returns
+    // false. The budget is checked only after a key is recovered, so
+    // each call makes progress. The number of nonzero cells is tracked
+    // incrementally, so success is known without a final scan of the
+    // table. Pass the same state to later calls to resume a stopped
+    // decode.
+    DecodeStatus decode(const DecodeSink &sink, DecodeState *state,
+                        const DecodeBudget &budget=DecodeBudget{0, 0});
+
+    // Decode several IBFs of the same set difference together. The
+    // IBFs should differ in seed (and may differ in n and k); every
+    // element peeled from one IBF is removed from all of them, so
+    // cells stuck in one IBF can be freed by peeling another.
+    // missingB and missingA are as in decode. All IBFs are consumed.
+    // Returns true if every IBF decoded to empty, false otherwise.
+    static bool jointDecode(const std::vector<InvBloom*> &ibfs,
+                            std::vector<uint64_t> *missingB,
+                            std::vector<uint64_t> *missingA);
+
     // Returns true if this IBF contains elt, false otherwise.
     bool contains(const uint64_t elt);
 
@@ -50,6 +164,21 @@ class InvBloom {
     // resulting from executing hash function.
     void encodeHash(const uint64_t &elt, int indices[]);
 
+    // Return true if this index is pure; false otherwise
+    // pure: count = 1 or -1
+    // checksumHash(idSum) = hashSum
+    bool isPure(int idx); 
+
+    // Hash functions shared with FixedInvBloom so both encode
+    // identical cells. An element's indices are taken from the chain
+    // indexHash(elt, seed), nextIndexHash(that), ...
+    static std::size_t indexHash(const uint64_t &elt, uint32_t seed);
+    static std::size_t nextIndexHash(std::size_t prev_hash);
+
+    // Return checksum hash; hash function should be distinct from
+    // that used for encodeHash.
+    static uint32_t checksumHash(const uint64_t &elt);
+
     std::string to_string() {
       std::string cells = "";
       for (int i = 0; i < n; i++) {
@@ -63,18 +192,39 @@ class InvBloom {
     }
 
   private: 
+    // Change tracking: the current (open) version, and per cell the
+    // version of its last change. cell_versions is empty if tracking
+    // is off.
+    uint32_t version;
+    std::vector<uint32_t> cell_versions;
+
+    // Record that cell idx changed in the current version.
+    void touch(int idx) {
+      if (!this->cell_versions.empty()) { this->cell_versions[idx] = this->version; }
+    }
+
+    // Return true if other and result can be combined cell by cell
+    // with this IBF (same n, k, hashing mode and seed).
+    bool compatible(const InvBloom &other, const InvBloom &result);
+
     // Subtract IBF cell "other" from this IBF and store the result
     // in result.
     void subtractCell(const uint32_t idx, const IbfCell &other, IbfCell *result);
 
-    // Return checksum hash; hash function should be distinct from
-    // that used for encodeHash.
-    uint32_t checksumHash(const uint64_t &elt);
-  
-    // Return true if this index is pure; false otherwise
-    // pure: count = 1 or -1
-    // checksumHash(idSum) = hashSum
-    bool isPure(int idx); 
+    // Remove elt, which contributes count c to each of its cells, from
+    // this IBF and add any cells that became pure to pure_idxs. If
+    // nonzero is given, keep it equal to the number of nonzero cells.
+    void peel(const uint64_t &elt, int c, std::vector<int> *pure_idxs,
+              uint32_t *nonzero=nullptr);
+
+    // Return true if any field of cell idx is nonzero.
+    bool isNonzero(int idx) {
+      const IbfCell &cell = this->table[idx];
+      return cell.count != 0 || cell.idSum != 0 || cell.hashSum != 0;
+    }
+
+    // Return true if every cell of this IBF is zero.
+    bool isEmpty();
 };
 
 /*
@@ -87,3 +237,4 @@ p = new T();
 p = new T(); // this is a memory leak
 */
 
+#endif // BLOOM_FILTER_H
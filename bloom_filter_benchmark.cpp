@@ -1,11 +1,16 @@
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstring>
 #include <fstream>
 #include <string>
 #include <iostream>
 #include <random>
 
 #include "bloom_filter.h"
+#include "compact_bloom_filter.h"
+#include "fixed_bloom_filter.h"
+#include "ibf_tuner.h"
 
 struct ExperimentResult {
   int totalCorrect;
@@ -240,23 +245,24 @@ void runExperiment(std::vector<uint64_t> u,
                    int k,
                    std::vector<uint64_t> u_sorted,
                    std::vector<uint64_t> v_sorted, 
-                   ExperimentResult* res) {
+                   ExperimentResult* res,
+                   float alpha=1.5) {
   std::vector<uint64_t> u_minus_v;
   std::vector<uint64_t> v_minus_u;
   for (int i = 0; i < iters; i++) {
 //    std::cout << "iter " << i << "\n";
     // Time the encode operation
     auto begin = std::chrono::steady_clock::now();
-    InvBloom* first = new InvBloom(d, k);
+    InvBloom* first = new InvBloom(d, k, alpha);
     first->encode(u);
     auto end = std::chrono::steady_clock::now();
     std::chrono::duration<double, std::milli> t_encode = end - begin;
 //    std::cout << "encoded\n";
-    InvBloom* second = new InvBloom(d, k);
+    InvBloom* second = new InvBloom(d, k, alpha);
     second->encode(v);
     
     // Time the subtract operation
-    InvBloom* result = new InvBloom(d, k);
+    InvBloom* result = new InvBloom(d, k, alpha);
     begin = std::chrono::steady_clock::now();
     first->subtract(*second, result);
     end = std::chrono::steady_clock::now();
@@ -301,6 +307,35 @@ bool onlyUnique(std::vector<uint64_t> v_sorted) {
   return true;
 } 
 
+// Set sizes swept by the per-size benchmarks.
+const std::vector<int> kSizes = {100, 500, 1000, 5000, 10000};
+
+// Input shared by the benchmarks: a vector pair, sorted copies for
+// checkSubtract, and the size of the symmetric difference.
+struct VectorPair {
+  int d;
+  std::vector<uint64_t> u;
+  std::vector<uint64_t> v;
+  std::vector<uint64_t> u_sorted;
+  std::vector<uint64_t> v_sorted;
+  int diff;
+};
+
+// Generate a pair of vectors of the given size that differ in about d
+// elements; d defaults to 30% of size.
+VectorPair makeVectorPair(int size, int d=-1) {
+  VectorPair pair;
+  pair.d = d < 0 ? (int) ceil(0.3*float(size)) : d;
+  generateVectorPair(size, pair.d, pair.u, pair.v);
+  pair.u_sorted = pair.u;
+  pair.v_sorted = pair.v;
+  std::sort(pair.u_sorted.begin(), pair.u_sorted.end());
+  std::sort(pair.v_sorted.begin(), pair.v_sorted.end());
+  pair.diff = getSetDiffSize(pair.u_sorted, pair.v_sorted) + \
+              getSetDiffSize(pair.v_sorted, pair.u_sorted);
+  return pair;
+}
+
 void runBenchmark(uint32_t iters, int k, int dScale, std::string resFile) {
   std::vector<int> sizes = {100, 500, 1000, 5000, 10000};
 //  std::vector<int> sizes = {30};
@@ -360,6 +395,455 @@ void runBenchmark(uint32_t iters, int k, int dScale, std::string resFile) {
   results.close();
 }
 
+// Same as runBenchmark, but sizes each IBF with tuneParams for the
+// actual difference size and target failure probability instead of
+// scaling d by hand.
+void runTunedBenchmark(uint32_t iters, double failureProb, std::string resFile) {
+  std::ofstream results;
+  results.open(resFile);
+  results << "size,distinct,totalCorrect,diffSize1,diffSize2,d,k,cells";
+  for (int i = 0; i < iters; i++) {
+    results << ",t_enc" << i << "(ms)";
+  }
+  for (int i = 0; i < iters; i++) {
+    results << ",t_sub" << i << "(ms)";
+  }
+  for (int i = 0; i < iters; i++) {
+    results << ",t_dec" << i << "(ms)";
+  }
+  results << "\n";
+  for (int s : kSizes) {
+    VectorPair pair = makeVectorPair(s);
+    IbfParams p = tuneParams(pair.diff, failureProb);
+
+    ExperimentResult res = { 0, {}, {} };  
+    runExperiment(pair.u, pair.v, iters, p.d, p.k, pair.u_sorted, \
+                  pair.v_sorted, &res, p.alpha);
+
+    results << s << "," << (onlyUnique(pair.u_sorted) && onlyUnique(pair.v_sorted)) << "," << res.totalCorrect << ",";
+    results << getSetDiffSize(pair.u_sorted, pair.v_sorted) << ",";
+    results << getSetDiffSize(pair.v_sorted, pair.u_sorted) << ",";
+    results << pair.d << "," << p.k << "," << p.n;
+    for (int i = 0; i < iters; i++) {
+      results << "," << res.ts_encode[i].count();
+    }
+    for (int i = 0; i < iters; i++) {
+      results << "," << res.ts_subtract[i].count();
+    }
+    for (int i = 0; i < iters; i++) {
+      results << "," << res.ts_decode[i].count();
+    }
+    results << "\n";
+  }
+  results.close();
+}
+
+// Encode foldable IBFs sized for dScale*d differences, then fold
+// both down one level at a time and record, per level, the cost of
+// folding one IBF and how often the folded difference decodes.
+void runFoldBenchmark(uint32_t iters, int k, int dScale, int levels, std::string resFile) {
+  std::ofstream results;
+  results.open(resFile);
+  results << "size,d,level,cells,totalCorrect";
+  for (int i = 0; i < iters; i++) {
+    results << ",t_fold" << i << "(ms)";
+  }
+  for (int i = 0; i < iters; i++) {
+    results << ",t_dec" << i << "(ms)";
+  }
+  results << "\n";
+  for (int s : kSizes) {
+    VectorPair pair = makeVectorPair(s);
+
+    InvBloom first(dScale*pair.d, k, 1.5, 1, levels);
+    InvBloom second(dScale*pair.d, k, 1.5, 1, levels);
+    first.encode(pair.u);
+    second.encode(pair.v);
+    for (int level = 0; level <= levels; level++) {
+      uint32_t factor = 1 << level;
+      int totalCorrect = 0;
+      std::vector<std::chrono::duration<double, std::milli>> ts_fold;
+      std::vector<std::chrono::duration<double, std::milli>> ts_decode;
+      for (int i = 0; i < iters; i++) {
+        InvBloom folded1(1, 1);
+        InvBloom folded2(1, 1);
+        auto begin = std::chrono::steady_clock::now();
+        first.fold(factor, &folded1);
+        auto end = std::chrono::steady_clock::now();
+        ts_fold.push_back(end - begin);
+        second.fold(factor, &folded2);
+
+        InvBloom result = folded1;
+        folded1.subtract(folded2, &result);
+        std::vector<uint64_t> u_minus_v;
+        std::vector<uint64_t> v_minus_u;
+        begin = std::chrono::steady_clock::now();
+        result.decode(&u_minus_v, &v_minus_u);
+        end = std::chrono::steady_clock::now();
+        ts_decode.push_back(end - begin);
+        if (checkSubtract(pair.u_sorted, pair.v_sorted, u_minus_v, v_minus_u, false)) {
+          totalCorrect++;
+        }
+      }
+      results << s << "," << pair.d << "," << level << "," << first.n / factor;
+      results << "," << totalCorrect;
+      for (int i = 0; i < iters; i++) {
+        results << "," << ts_fold[i].count();
+      }
+      for (int i = 0; i < iters; i++) {
+        results << "," << ts_decode[i].count();
+      }
+      results << "\n";
+    }
+  }
+  results.close();
+}
+
+// Compare two ways of retrying a failed decode of an IBF with
+// alpha*diff cells: joint decoding with a second IBF of the same size
+// but a different seed, versus a fresh IBF with twice the cells.
+// Both retries send the same number of extra cells.
+void runJointBenchmark(uint32_t iters, int k, float alpha, std::string resFile) {
+  std::ofstream results;
+  results.open(resFile);
+  results << "size,diffSize,cells,singleCorrect,jointCorrect,doubleCorrect";
+  for (int i = 0; i < iters; i++) {
+    results << ",t_joint" << i << "(ms)";
+  }
+  for (int i = 0; i < iters; i++) {
+    results << ",t_double" << i << "(ms)";
+  }
+  results << "\n";
+  for (int s : kSizes) {
+    VectorPair pair = makeVectorPair(s);
+
+    int singleCorrect = 0, jointCorrect = 0, doubleCorrect = 0;
+    std::vector<std::chrono::duration<double, std::milli>> ts_joint;
+    std::vector<std::chrono::duration<double, std::milli>> ts_double;
+    for (int i = 0; i < iters; i++) {
+      // Seeds vary per iteration so each one sees different cells.
+      std::vector<InvBloom> diffs;
+      for (uint32_t seed : {2*i + 1, 2*i + 2}) {
+        InvBloom first(pair.diff, k, alpha, 1, 0, seed);
+        InvBloom second(pair.diff, k, alpha, 1, 0, seed);
+        first.encode(pair.u);
+        second.encode(pair.v);
+        InvBloom result = first;
+        first.subtract(second, &result);
+        diffs.push_back(result);
+      }
+      std::vector<uint64_t> u_minus_v;
+      std::vector<uint64_t> v_minus_u;
+      InvBloom single = diffs[0];
+      single.decode(&u_minus_v, &v_minus_u);
+      if (checkSubtract(pair.u_sorted, pair.v_sorted, u_minus_v, v_minus_u, false)) {
+        singleCorrect++;
+      }
+
+      u_minus_v.clear();
+      v_minus_u.clear();
+      std::vector<InvBloom*> ibfs = {&diffs[0], &diffs[1]};
+      auto begin = std::chrono::steady_clock::now();
+      InvBloom::jointDecode(ibfs, &u_minus_v, &v_minus_u);
+      auto end = std::chrono::steady_clock::now();
+      ts_joint.push_back(end - begin);
+      if (checkSubtract(pair.u_sorted, pair.v_sorted, u_minus_v, v_minus_u, false)) {
+        jointCorrect++;
+      }
+
+      u_minus_v.clear();
+      v_minus_u.clear();
+      InvBloom first(pair.diff, k, 2*alpha, 1, 0, 2*i + 1);
+      InvBloom second(pair.diff, k, 2*alpha, 1, 0, 2*i + 1);
+      first.encode(pair.u);
+      second.encode(pair.v);
+      InvBloom result = first;
+      first.subtract(second, &result);
+      begin = std::chrono::steady_clock::now();
+      result.decode(&u_minus_v, &v_minus_u);
+      end = std::chrono::steady_clock::now();
+      ts_double.push_back(end - begin);
+      if (checkSubtract(pair.u_sorted, pair.v_sorted, u_minus_v, v_minus_u, false)) {
+        doubleCorrect++;
+      }
+    }
+    results << s << "," << pair.diff << "," << (int) ceil(pair.diff*alpha) << ",";
+    results << singleCorrect << "," << jointCorrect << "," << doubleCorrect;
+    for (int i = 0; i < iters; i++) {
+      results << "," << ts_joint[i].count();
+    }
+    for (int i = 0; i < iters; i++) {
+      results << "," << ts_double[i].count();
+    }
+    results << "\n";
+  }
+  results.close();
+}
+
+// Keep a mirror of a tracked IBF sized for d = 10000 in sync over
+// rounds of varying numbers of inserts, and compare the bytes of each
+// delta (index + cell per changed cell) with resending the table.
+void runDeltaBenchmark(int k, std::string resFile) {
+  std::vector<int> updates = {1, 10, 100, 1000, 10000};
+  std::ofstream results;
+  results.open(resFile);
+  results << "updates,cells,deltaCells,deltaBytes,fullBytes,t_emit(ms),t_apply(ms)\n";
+  InvBloom sketch(10000, k);
+  InvBloom mirror(10000, k);
+  sketch.trackChanges();
+  uint32_t mirror_version = 0;
+  std::mt19937_64 rng(std::random_device{}());
+  IbfDelta delta;
+  for (int u : updates) {
+    for (int i = 0; i < u; i++) { sketch.insert(rng()); }
+    auto begin = std::chrono::steady_clock::now();
+    sketch.emitDelta(mirror_version, &delta);
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> t_emit = end - begin;
+    begin = std::chrono::steady_clock::now();
+    mirror.applyDelta(delta, &mirror_version);
+    end = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> t_apply = end - begin;
+    results << u << "," << sketch.n << "," << delta.idxs.size() << ",";
+    results << delta.idxs.size() * (sizeof(uint32_t) + sizeof(IbfCell)) << ",";
+    results << sketch.n * sizeof(IbfCell) << "," << t_emit.count() << ",";
+    results << t_apply.count() << "\n";
+  }
+  results.close();
+}
+
+// Time encode, copy, subtract and decode of a FixedInvBloom<N, K>
+// against an InvBloom with the same n and k, for sets of 100
+// elements that differ in at most about N/4 elements. Writes one row of mean
+// times (ms) per type to results.
+template <uint32_t N, uint32_t K>
+void runFixedBenchmark(uint32_t iters, std::ofstream &results) {
+  VectorPair pair = makeVectorPair(100, N / 4);
+
+  std::chrono::duration<double, std::milli> fixed_enc(0), fixed_copy(0),
+    fixed_sub(0), fixed_dec(0), dyn_enc(0), dyn_copy(0), dyn_sub(0), dyn_dec(0);
+  int fixedCorrect = 0, dynamicCorrect = 0;
+  char message[sizeof(FixedInvBloom<N, K>)];
+  for (int i = 0; i < iters; i++) {
+    std::vector<uint64_t> u_minus_v;
+    std::vector<uint64_t> v_minus_u;
+
+    auto begin = std::chrono::steady_clock::now();
+    FixedInvBloom<N, K> fixed1;
+    fixed1.encode(pair.u);
+    auto end = std::chrono::steady_clock::now();
+    fixed_enc += end - begin;
+    FixedInvBloom<N, K> fixed2;
+    fixed2.encode(pair.v);
+    begin = std::chrono::steady_clock::now();
+    memcpy(message, &fixed2, sizeof(message));
+    FixedInvBloom<N, K> received;
+    memcpy(&received, message, sizeof(message));
+    end = std::chrono::steady_clock::now();
+    fixed_copy += end - begin;
+    FixedInvBloom<N, K> fixed_diff;
+    begin = std::chrono::steady_clock::now();
+    fixed1.subtract(received, &fixed_diff);
+    end = std::chrono::steady_clock::now();
+    fixed_sub += end - begin;
+    begin = std::chrono::steady_clock::now();
+    fixed_diff.decode(&u_minus_v, &v_minus_u);
+    end = std::chrono::steady_clock::now();
+    fixed_dec += end - begin;
+    if (checkSubtract(pair.u_sorted, pair.v_sorted, u_minus_v, v_minus_u, false)) {
+      fixedCorrect++;
+    }
+
+    u_minus_v.clear();
+    v_minus_u.clear();
+    begin = std::chrono::steady_clock::now();
+    InvBloom dynamic1(N, K, 1.0);
+    dynamic1.encode(pair.u);
+    end = std::chrono::steady_clock::now();
+    dyn_enc += end - begin;
+    InvBloom dynamic2(N, K, 1.0);
+    dynamic2.encode(pair.v);
+    begin = std::chrono::steady_clock::now();
+    InvBloom dynamic_received = dynamic2;
+    end = std::chrono::steady_clock::now();
+    dyn_copy += end - begin;
+    InvBloom dynamic_diff(N, K, 1.0);
+    begin = std::chrono::steady_clock::now();
+    dynamic1.subtract(dynamic_received, &dynamic_diff);
+    end = std::chrono::steady_clock::now();
+    dyn_sub += end - begin;
+    begin = std::chrono::steady_clock::now();
+    dynamic_diff.decode(&u_minus_v, &v_minus_u);
+    end = std::chrono::steady_clock::now();
+    dyn_dec += end - begin;
+    if (checkSubtract(pair.u_sorted, pair.v_sorted, u_minus_v, v_minus_u, false)) {
+      dynamicCorrect++;
+    }
+  }
+  results << "fixed," << N << "," << K << "," << pair.diff << "," << fixedCorrect;
+  results << "," << fixed_enc.count() / iters << "," << fixed_copy.count() / iters;
+  results << "," << fixed_sub.count() / iters << "," << fixed_dec.count() / iters << "\n";
+  results << "dynamic," << N << "," << K << "," << pair.diff << "," << dynamicCorrect;
+  results << "," << dyn_enc.count() / iters << "," << dyn_copy.count() / iters;
+  results << "," << dyn_sub.count() / iters << "," << dyn_dec.count() / iters << "\n";
+}
+
+// For each size, time how long the streaming decode takes to hand
+// out its first key versus how long the whole decode takes.
+void runStreamingBenchmark(uint32_t iters, int k, std::string resFile) {
+  std::ofstream results;
+  results.open(resFile);
+  results << "size,diffSize,totalCorrect";
+  for (int i = 0; i < iters; i++) {
+    results << ",t_first" << i << "(ms)";
+  }
+  for (int i = 0; i < iters; i++) {
+    results << ",t_dec" << i << "(ms)";
+  }
+  results << "\n";
+  for (int s : kSizes) {
+    VectorPair pair = makeVectorPair(s);
+    InvBloom first(pair.diff, k);
+    InvBloom second(pair.diff, k);
+    first.encode(pair.u);
+    second.encode(pair.v);
+
+    int totalCorrect = 0;
+    std::vector<std::chrono::duration<double, std::milli>> ts_first;
+    std::vector<std::chrono::duration<double, std::milli>> ts_decode;
+    for (int i = 0; i < iters; i++) {
+      InvBloom result = first;
+      first.subtract(second, &result);
+      std::vector<uint64_t> u_minus_v;
+      std::vector<uint64_t> v_minus_u;
+      DecodeState state;
+      auto begin = std::chrono::steady_clock::now();
+      auto firstKey = begin;
+      DecodeStatus status = result.decode([&](uint64_t key, int side) {
+        if (u_minus_v.empty() && v_minus_u.empty()) {
+          firstKey = std::chrono::steady_clock::now();
+        }
+        (side > 0 ? u_minus_v : v_minus_u).push_back(key);
+        return true;
+      }, &state);
+      auto end = std::chrono::steady_clock::now();
+      ts_first.push_back(firstKey - begin);
+      ts_decode.push_back(end - begin);
+      if (status == kDecodeSuccess &&
+          checkSubtract(pair.u_sorted, pair.v_sorted, u_minus_v, v_minus_u, false)) {
+        totalCorrect++;
+      }
+    }
+    results << s << "," << pair.diff << "," << totalCorrect;
+    for (int i = 0; i < iters; i++) {
+      results << "," << ts_first[i].count();
+    }
+    for (int i = 0; i < iters; i++) {
+      results << "," << ts_decode[i].count();
+    }
+    results << "\n";
+  }
+  results.close();
+}
+
+int cellCount(InvBloom &ibf, int i) { return ibf.table[i].count; }
+int cellCount(CompactInvBloom &ibf, int i) { return ibf.count(i); }
+
+// Measure one cell layout (IbfCell or CompactIbfCell). overloaded and
+// sized are empty IBFs that are copied for each run.
+// False purity: encode a random difference of 2*overloaded.n keys
+// (half on each side) so many cells hold several keys, and count the
+// cells with count +-1 but more than one key that isPure accepts.
+// Throughput: mean encode/subtract/decode times and decode successes
+// for the sets u and v in IBFs shaped like sized.
+template <typename T>
+void runCellBenchmark(std::string name, uint32_t iters, const T &overloaded,
+                      const T &sized, const VectorPair &pair,
+                      std::ofstream &results) {
+  std::mt19937_64 rng(std::random_device{}());
+  long impureCandidates = 0, falsePure = 0;
+  for (int it = 0; it < iters; it++) {
+    std::vector<uint64_t> onlyA;
+    std::vector<uint64_t> onlyB;
+    for (int i = 0; i < overloaded.n; i++) {
+      onlyA.push_back(rng());
+      onlyB.push_back(rng());
+    }
+    T a = overloaded;
+    T b = overloaded;
+    a.encode(onlyA);
+    b.encode(onlyB);
+    T diff = overloaded;
+    a.subtract(b, &diff);
+    // Ground truth: number of keys hashed to each cell.
+    std::vector<int> keys(overloaded.n, 0);
+    int idxs[overloaded.k];
+    for (auto *side : {&onlyA, &onlyB}) {
+      for (uint64_t elt : *side) {
+        diff.encodeHash(elt, idxs);
+        for (int j : idxs) { keys[j]++; }
+      }
+    }
+    for (int i = 0; i < diff.n; i++) {
+      int c = cellCount(diff, i);
+      if ((c == 1 || c == -1) && keys[i] > 1) {
+        impureCandidates++;
+        if (diff.isPure(i)) { falsePure++; }
+      }
+    }
+  }
+
+  std::chrono::duration<double, std::milli> t_enc(0), t_sub(0), t_dec(0);
+  int totalCorrect = 0;
+  for (int it = 0; it < iters; it++) {
+    auto begin = std::chrono::steady_clock::now();
+    T first = sized;
+    first.encode(pair.u);
+    auto end = std::chrono::steady_clock::now();
+    t_enc += end - begin;
+    T second = sized;
+    second.encode(pair.v);
+    T result = sized;
+    begin = std::chrono::steady_clock::now();
+    first.subtract(second, &result);
+    end = std::chrono::steady_clock::now();
+    t_sub += end - begin;
+    std::vector<uint64_t> u_minus_v;
+    std::vector<uint64_t> v_minus_u;
+    begin = std::chrono::steady_clock::now();
+    result.decode(&u_minus_v, &v_minus_u);
+    end = std::chrono::steady_clock::now();
+    t_dec += end - begin;
+    if (checkSubtract(pair.u_sorted, pair.v_sorted, u_minus_v, v_minus_u, false)) {
+      totalCorrect++;
+    }
+  }
+
+  results << name << "," << sizeof(sized.table[0]) << ",";
+  results << sized.n * sizeof(sized.table[0]) << "," << impureCandidates << ",";
+  results << falsePure << "," << (double) falsePure / impureCandidates << ",";
+  results << totalCorrect << "," << t_enc.count() / iters << ",";
+  results << t_sub.count() / iters << "," << t_dec.count() / iters << "\n";
+}
+
+// Compare IbfCell against checksum-free CompactIbfCell with 0, 4 and
+// 8 fingerprint bits.
+void runCompactBenchmark(uint32_t iters, int k, std::string resFile) {
+  std::ofstream results;
+  results.open(resFile);
+  results << "cell,cellBytes,tableBytes,impureCandidates,falsePure,falsePureRate,";
+  results << "totalCorrect,t_enc(ms),t_sub(ms),t_dec(ms)\n";
+  VectorPair pair = makeVectorPair(5000);
+  runCellBenchmark("IbfCell", iters, InvBloom(1000, k, 1.0),
+                   InvBloom(pair.diff, k), pair, results);
+  for (uint32_t fp_bits : {0, 4, 8}) {
+    runCellBenchmark("CompactIbfCell fp_bits=" + std::to_string(fp_bits), iters,
+                     CompactInvBloom(1000, k, 1.0, fp_bits),
+                     CompactInvBloom(pair.diff, k, 1.5, fp_bits), pair, results);
+  }
+  results.close();
+}
+
 int main() {
   std::string fnameBase = "benchmarkResults/iter_10_k_3_dScale_";
   std::vector<int> dScales = {1, 2, 4, 5, 8, 10, 20};
@@ -367,4 +851,25 @@ int main() {
     runBenchmark(10, 3, dScale, fnameBase + std::to_string(dScale) + ".txt");
   }
   std::cout << "Output written to iter_10_k_3_dScale_{1,2,4,5,8,10,20}.txt\n";
+  runTunedBenchmark(10, 1e-3, "benchmarkResults/iter_10_tuned_p_0.001.txt");
+  std::cout << "Output written to iter_10_tuned_p_0.001.txt\n";
+  runFoldBenchmark(10, 3, 8, 3, "benchmarkResults/iter_10_k_3_fold_8x.txt");
+  std::cout << "Output written to iter_10_k_3_fold_8x.txt\n";
+  runJointBenchmark(10, 3, 1.0, "benchmarkResults/iter_10_k_3_joint_alpha_1.txt");
+  std::cout << "Output written to iter_10_k_3_joint_alpha_1.txt\n";
+  std::ofstream fixedResults;
+  fixedResults.open("benchmarkResults/iter_1000_fixed.txt");
+  fixedResults << "type,N,K,diffSize,totalCorrect,t_enc(ms),t_copy(ms),t_sub(ms),t_dec(ms)\n";
+  runFixedBenchmark<16, 3>(1000, fixedResults);
+  runFixedBenchmark<24, 3>(1000, fixedResults);
+  runFixedBenchmark<32, 3>(1000, fixedResults);
+  runFixedBenchmark<64, 4>(1000, fixedResults);
+  fixedResults.close();
+  std::cout << "Output written to iter_1000_fixed.txt\n";
+  runDeltaBenchmark(3, "benchmarkResults/k_3_delta.txt");
+  std::cout << "Output written to k_3_delta.txt\n";
+  runCompactBenchmark(10, 3, "benchmarkResults/iter_10_k_3_compact.txt");
+  std::cout << "Output written to iter_10_k_3_compact.txt\n";
+  runStreamingBenchmark(10, 3, "benchmarkResults/iter_10_k_3_streaming.txt");
+  std::cout << "Output written to iter_10_k_3_streaming.txt\n";
 } 
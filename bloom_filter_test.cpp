@@ -1,9 +1,34 @@
 #include "bloom_filter.h"
+#include "compact_bloom_filter.h"
+#include "epoch_bloom_filter.h"
+#include "fixed_bloom_filter.h"
+#include "ibf_tuner.h"
 #include <assert.h>
 #include <stdio.h>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
 #include <iostream>
+#include <random>
+
+// Two overlapping sets shared by the IBF variant tests, and their
+// sorted differences.
+const std::vector<uint64_t> kS1 = {54, 99, 51, 95, 35, 86, 73, \
+                                   41, 3, 33, 61, 19, 87, 93, 83};
+const std::vector<uint64_t> kS2 = {54, 99, 12, 95, 35, 4, 73, \
+                                   41, 21, 33, 61, 19, 6, 93};
+const std::vector<uint64_t> kS1MinusS2 = {3, 51, 83, 86, 87};
+const std::vector<uint64_t> kS2MinusS1 = {4, 6, 12, 21};
+
+// Sort decoded differences and compare them to kS1 - kS2 (missingB)
+// and kS2 - kS1 (missingA).
+void checkDifference(std::vector<uint64_t> missingB,
+                     std::vector<uint64_t> missingA) {
+  std::sort(missingB.begin(), missingB.end());
+  std::sort(missingA.begin(), missingA.end());
+  assert(missingB == kS1MinusS2);
+  assert(missingA == kS2MinusS1);
+}
 
 void testConstructor() {
   int d = 10;
@@ -161,6 +186,488 @@ void testSubtract() {
   fprintf(stdout, "passed testSubtract\n");
 }
 
+void testTuneParams() {
+  // Parameters are consistent with the InvBloom constructor and
+  // never shrink for a larger difference or a stricter target.
+  for (double prob : {1e-1, 1e-2, 1e-3, 1e-4}) {
+    uint32_t prev_n = 0;
+    for (uint32_t d = 1; d <= 3000; d++) {
+      IbfParams p = tuneParams(d, prob);
+      assert(p.d == d);
+      assert(p.k >= kTunerMinK && p.k < kTunerMinK + kTunerNumK);
+      assert(p.n >= p.k);
+      assert(p.n >= prev_n);
+      assert(tuneParams(d, prob / 10).n >= p.n);
+      prev_n = p.n;
+    }
+  }
+  for (uint32_t d : {1, 5, 20, 100, 1000, 5000}) {
+    IbfParams p = tuneParams(d, 1e-2);
+    InvBloom ibf(p.d, p.k, p.alpha);
+    assert(ibf.n == p.n);
+  }
+
+  // d = 0 is tuned as d = 1 and builds a usable table.
+  IbfParams empty = tuneParams(0, 1e-2);
+  assert(empty.d == 1);
+  assert(InvBloom(empty.d, empty.k, empty.alpha).n == empty.n);
+
+  // Targets outside (0, 1) are clamped, not extrapolated.
+  uint32_t strictest = tuneParams(10, kTunerMinP).n;
+  assert(strictest > tuneParams(10, 1e-3).n);
+  assert(tuneParams(10, 0.0).n == strictest);
+  assert(tuneParams(10, -1.0).n == strictest);
+  assert(tuneParams(10, NAN).n == strictest);
+  assert(tuneParams(10, 2.0).n == tuneParams(10, 1e-1).n);
+
+  // Tuned tables decode random differences at about the target
+  // failure rate (loose bound to keep the test stable).
+  uint32_t d = 20;
+  IbfParams p = tuneParams(d, 1e-2);
+  std::mt19937_64 rng(42);
+  int failures = 0;
+  int trials = 200;
+  for (int t = 0; t < trials; t++) {
+    std::vector<uint64_t> items;
+    for (int i = 0; i < d; i++) { items.push_back(rng()); }
+    InvBloom ibf(p.d, p.k, p.alpha);
+    ibf.encode(items);
+    std::vector<uint64_t> decoded;
+    std::vector<uint64_t> expect_empty;
+    if (!ibf.decode(&decoded, &expect_empty)) { failures++; }
+  }
+  assert(failures <= trials / 20);
+  fprintf(stdout, "passed testTuneParams (d=%u: k=%u, n=%u, failures: %d/%d)\n",
+          d, p.k, p.n, failures, trials);
+}
+
+void testFold() {
+  int d = 40;
+  int k = 3;
+  // Foldable IBFs sized for 40 differences; n is rounded up to a
+  // multiple of k*2^3 = 24.
+  InvBloom* ibf1 = new InvBloom(d, k, 1.5, 1, 3);
+  InvBloom* ibf2 = new InvBloom(d, k, 1.5, 1, 3);
+  assert(ibf1->partitioned);
+  assert(ibf1->n == 72);
+  std::vector<uint64_t> s1 = {54, 99, 51, 95, 35, 86, 73, \
+                              41, 3, 33, 61, 19, 87, 93, 83};
+  std::vector<uint64_t> s2 = {54, 99, 12, 95, 35, 73, \
+                              41, 33, 61, 19, 93, 83};
+  ibf1->encode(s1);
+  ibf2->encode(s2);
+
+  // Indices stay within their sub-tables.
+  int idxs[k];
+  ibf1->encodeHash(6458, idxs);
+  for (int i = 0; i < k; i++) {
+    assert(idxs[i] / (ibf1->n / k) == i);
+  }
+
+  // Folding commutes with subtract: fold(A - B) == fold(A) - fold(B).
+  InvBloom* diff = new InvBloom(d, k, 1.5, 1, 3);
+  assert(ibf1->subtract(*ibf2, diff));
+  InvBloom* folded_diff = new InvBloom(1, 1);
+  InvBloom* folded1 = new InvBloom(1, 1);
+  InvBloom* folded2 = new InvBloom(1, 1);
+  assert(diff->fold(2, folded_diff));
+  assert(ibf1->fold(2, folded1));
+  assert(ibf2->fold(2, folded2));
+  assert(folded_diff->n == 36);
+  InvBloom* diff_folded = new InvBloom(1, 1);
+  *diff_folded = *folded1;
+  assert(folded1->subtract(*folded2, diff_folded));
+  for (int i = 0; i < folded_diff->n; i++) {
+    assert(folded_diff->table[i].count == diff_folded->table[i].count);
+    assert(folded_diff->table[i].idSum == diff_folded->table[i].idSum);
+    assert(folded_diff->table[i].hashSum == diff_folded->table[i].hashSum);
+  }
+
+  // The 5-element difference still decodes from a 4x fold.
+  assert(diff->fold(4, diff));
+  assert(diff->n == 18);
+  std::vector<uint64_t> mB_actual;
+  std::vector<uint64_t> mA_actual;
+  assert(diff->decode(&mB_actual, &mA_actual));
+  std::sort(mB_actual.begin(), mB_actual.end());
+  std::vector<uint64_t> mB_expected = {3, 51, 86, 87};
+  assert(mB_actual == mB_expected);
+  assert(mA_actual.size() == 1 && mA_actual[0] == 12);
+
+  // Folds must divide the sub-table, and classic IBFs cannot fold.
+  assert(!ibf1->fold(5, folded1));
+  InvBloom* classic = new InvBloom(d, k);
+  assert(!classic->fold(2, folded1));
+  fprintf(stdout, "passed testFold\n");
+}
+
+void testJointDecode() {
+  // 30 differences in two 30-cell IBFs: each alone is below the
+  // peeling threshold, together they hold 2 cells per element.
+  int d = 30;
+  int k = 3;
+  std::mt19937_64 rng(7);
+  std::vector<uint64_t> items;
+  for (int i = 0; i < d; i++) { items.push_back(rng()); }
+  InvBloom* ibf1 = new InvBloom(d, k, 1.0, 1, 0, 1);
+  InvBloom* ibf2 = new InvBloom(d, k, 1.0, 1, 0, 2);
+  ibf1->encode(items);
+  ibf2->encode(items);
+
+  // Different seeds place the same element in different cells.
+  int idxs1[k];
+  int idxs2[k];
+  ibf1->encodeHash(items[0], idxs1);
+  ibf2->encodeHash(items[0], idxs2);
+  assert(!std::equal(idxs1, idxs1 + k, idxs2));
+
+  // IBFs with different seeds cannot be subtracted.
+  InvBloom* result = new InvBloom(d, k, 1.0, 1, 0, 1);
+  assert(!ibf1->subtract(*ibf2, result));
+
+  InvBloom single1 = *ibf1;
+  InvBloom single2 = *ibf2;
+  std::vector<uint64_t> decoded;
+  std::vector<uint64_t> expect_empty;
+  bool success1 = single1.decode(&decoded, &expect_empty);
+  decoded.clear();
+  bool success2 = single2.decode(&decoded, &expect_empty);
+  decoded.clear();
+  assert(!success1 && !success2);
+
+  std::vector<InvBloom*> ibfs = {ibf1, ibf2};
+  assert(InvBloom::jointDecode(ibfs, &decoded, &expect_empty));
+  assert(expect_empty.size() == 0);
+  std::sort(decoded.begin(), decoded.end());
+  std::sort(items.begin(), items.end());
+  assert(decoded == items);
+  fprintf(stdout, "passed testJointDecode\n");
+}
+
+void testEpochWindow() {
+  int d = 10;
+  int k = 3;
+  EpochInvBloom* a = new EpochInvBloom(3, d, k);
+  EpochInvBloom* b = new EpochInvBloom(3, d, k);
+  std::vector<std::vector<uint64_t>> epochs = {{1, 2}, {3}, {4, 5}, {6}};
+  for (int e = 0; e < epochs.size(); e++) {
+    if (e > 0) {
+      a->advanceEpoch();
+      b->advanceEpoch();
+    }
+    a->encode(epochs[e]);
+    b->encode(epochs[e]);
+  }
+  // b is missing 7 and has an extra 8 in the current epoch.
+  a->insert(7);
+  b->insert(8);
+  assert(a->current_epoch == 3);
+  assert(a->oldestEpoch() == 1);
+
+  // Epoch 0 has expired.
+  InvBloom* window = new InvBloom(d, k);
+  assert(!a->window(0, 3, window));
+
+  // The full window matches an IBF encoded from the live epochs.
+  InvBloom* expected = new InvBloom(d, k);
+  expected->encode({3, 4, 5, 6, 7});
+  assert(a->window(1, 3, window));
+  for (int i = 0; i < window->n; i++) {
+    assert(window->table[i].count == expected->table[i].count);
+    assert(window->table[i].idSum == expected->table[i].idSum);
+    assert(window->table[i].hashSum == expected->table[i].hashSum);
+  }
+
+  // Sub-ranges decode to just their epochs.
+  assert(a->window(1, 2, window));
+  std::vector<uint64_t> decoded;
+  std::vector<uint64_t> expect_empty;
+  assert(window->decode(&decoded, &expect_empty));
+  std::sort(decoded.begin(), decoded.end());
+  assert(decoded == std::vector<uint64_t>({3, 4, 5}));
+
+  // Replicas reconcile the window by subtracting window sketches.
+  InvBloom* window_b = new InvBloom(d, k);
+  assert(a->window(1, 3, window));
+  assert(b->window(1, 3, window_b));
+  assert(window->subtract(*window_b, window));
+  decoded.clear();
+  assert(window->decode(&decoded, &expect_empty));
+  assert(decoded == std::vector<uint64_t>({7}));
+  assert(expect_empty == std::vector<uint64_t>({8}));
+  fprintf(stdout, "passed testEpochWindow\n");
+}
+
+void testFixedInvBloom() {
+  static_assert(std::is_trivially_copyable<FixedInvBloom<32, 3>>::value,
+                "FixedInvBloom must be trivially copyable");
+  static_assert(sizeof(FixedInvBloom<32, 3>) == 32 * sizeof(IbfCell),
+                "FixedInvBloom must hold only its cells");
+  FixedInvBloom<32, 3> fixed1;
+  FixedInvBloom<32, 3> fixed2;
+  fixed1.encode(kS1);
+  fixed2.encode(kS2);
+
+  // Same cells as a dynamic IBF with n = 32, k = 3.
+  InvBloom* dynamic1 = new InvBloom(32, 3, 1.0);
+  dynamic1->encode(kS1);
+  InvBloom* converted = new InvBloom(1, 1);
+  fixed1.toInvBloom(converted);
+  assert(converted->n == 32 && converted->k == 3);
+  for (int i = 0; i < 32; i++) {
+    assert(converted->table[i].count == dynamic1->table[i].count);
+    assert(converted->table[i].idSum == dynamic1->table[i].idSum);
+    assert(converted->table[i].hashSum == dynamic1->table[i].hashSum);
+  }
+
+  // Survives a round trip through a message buffer.
+  char message[sizeof(FixedInvBloom<32, 3>)];
+  memcpy(message, &fixed2, sizeof(message));
+  FixedInvBloom<32, 3> received;
+  memcpy(&received, message, sizeof(message));
+
+  FixedInvBloom<32, 3> diff;
+  fixed1.subtract(received, &diff);
+  std::vector<uint64_t> mB_actual;
+  std::vector<uint64_t> mA_actual;
+  assert(diff.decode(&mB_actual, &mA_actual));
+  checkDifference(mB_actual, mA_actual);
+
+  // A dynamic IBF minus a fixed one, decoded as a fixed IBF.
+  fixed2.toInvBloom(converted);
+  InvBloom* dynamic_diff = new InvBloom(32, 3, 1.0);
+  assert(dynamic1->subtract(*converted, dynamic_diff));
+  assert(diff.fromInvBloom(*dynamic_diff));
+  mB_actual.clear();
+  mA_actual.clear();
+  assert(diff.decode(&mB_actual, &mA_actual));
+  checkDifference(mB_actual, mA_actual);
+  assert(!diff.fromInvBloom(InvBloom(10, 3)));
+
+  // A corrupt cell that passes the checksum but whose key hashes
+  // elsewhere fails instead of being peeled forever.
+  uint64_t stray = 1;
+  uint32_t stray_idxs[3];
+  FixedInvBloom<32, 3>::encodeHash(stray, stray_idxs);
+  uint32_t bad = 0;
+  while (std::find(stray_idxs, stray_idxs + 3, bad) != stray_idxs + 3) { bad++; }
+  FixedInvBloom<32, 3> corrupt;
+  corrupt.table[bad] = IbfCell{1, stray, InvBloom::checksumHash(stray)};
+  mB_actual.clear();
+  mA_actual.clear();
+  assert(!corrupt.decode(&mB_actual, &mA_actual));
+  fprintf(stdout, "passed testFixedInvBloom\n");
+}
+
+void testDeltaSync() {
+  int d = 100;
+  int k = 3;
+  InvBloom* sketch = new InvBloom(d, k);
+  std::vector<uint64_t> items = {54, 99, 51, 95, 35, 86, 73};
+  sketch->encode(items);
+  sketch->trackChanges();
+
+  // A fresh mirror syncs from version 0 and receives only the cells
+  // the sketch has touched.
+  InvBloom* mirror = new InvBloom(d, k);
+  uint32_t mirror_version = 0;
+  IbfDelta delta;
+  assert(sketch->emitDelta(mirror_version, &delta));
+  assert(delta.idxs.size() > 0 && delta.idxs.size() <= items.size() * k);
+  assert(mirror->applyDelta(delta, &mirror_version));
+  assert(mirror_version == delta.version);
+
+  // Later rounds carry only the cells changed since the last one.
+  sketch->insert(41);
+  sketch->insert(3);
+  assert(sketch->emitDelta(mirror_version, &delta));
+  assert(delta.idxs.size() > 0 && delta.idxs.size() <= 2 * k);
+  IbfDelta stale = delta;
+  assert(mirror->applyDelta(delta, &mirror_version));
+  for (int i = 0; i < sketch->n; i++) {
+    assert(mirror->table[i].count == sketch->table[i].count);
+    assert(mirror->table[i].idSum == sketch->table[i].idSum);
+    assert(mirror->table[i].hashSum == sketch->table[i].hashSum);
+  }
+
+  // Nothing changed: empty delta. Re-applying an old delta fails.
+  assert(sketch->emitDelta(mirror_version, &delta));
+  assert(delta.idxs.size() == 0);
+  assert(!mirror->applyDelta(stale, &mirror_version));
+  assert(mirror->applyDelta(delta, &mirror_version));
+
+  // The mirror decodes like the sketch itself.
+  std::vector<uint64_t> decoded;
+  std::vector<uint64_t> expect_empty;
+  assert(mirror->decode(&decoded, &expect_empty));
+  assert(decoded.size() == items.size() + 2);
+
+  // Malformed deltas and deltas from a differently hashed IBF are
+  // rejected without touching the mirror.
+  sketch->insert(21);
+  assert(sketch->emitDelta(mirror_version, &delta));
+  IbfDelta truncated = delta;
+  truncated.cells.pop_back();
+  assert(!mirror->applyDelta(truncated, &mirror_version));
+  IbfDelta reseeded = delta;
+  reseeded.seed = 1;
+  assert(!mirror->applyDelta(reseeded, &mirror_version));
+  InvBloom* foldable = new InvBloom(d, k, 1.5, 1, 1);
+  uint32_t foldable_version = delta.since;
+  IbfDelta partitioned = delta;
+  partitioned.n = foldable->n;
+  partitioned.idxs.clear();
+  partitioned.cells.clear();
+  assert(!foldable->applyDelta(partitioned, &foldable_version));
+  assert(mirror->applyDelta(delta, &mirror_version));
+
+  // Versions that were never emitted are rejected.
+  assert(!sketch->emitDelta(mirror_version + 1, &delta));
+  fprintf(stdout, "passed testDeltaSync\n");
+}
+
+void testCompactInvBloom() {
+  assert(sizeof(CompactIbfCell) == 12);
+  int d = 10;
+  int k = 3;
+
+  // Same cell indices as the classic InvBloom.
+  InvBloom* classic = new InvBloom(d, k);
+  CompactInvBloom* compact = new CompactInvBloom(d, k);
+  int classic_idxs[k];
+  int compact_idxs[k];
+  classic->encodeHash(6458, classic_idxs);
+  compact->encodeHash(6458, compact_idxs);
+  std::sort(compact_idxs, compact_idxs + k);
+  assert(std::equal(classic_idxs, classic_idxs + k, compact_idxs));
+
+  for (uint32_t fp_bits : {0, 8}) {
+    CompactInvBloom* ibf1 = new CompactInvBloom(d, k, 1.5, fp_bits);
+    CompactInvBloom* ibf2 = new CompactInvBloom(d, k, 1.5, fp_bits);
+    ibf1->encode(kS1);
+    ibf2->encode(kS2);
+    CompactInvBloom* subtracted = new CompactInvBloom(d, k, 1.5, fp_bits);
+    assert(ibf1->subtract(*ibf2, subtracted));
+    // Negative counts survive packing next to the fingerprint.
+    int total = 0;
+    for (int i = 0; i < subtracted->n; i++) { total += subtracted->count(i); }
+    assert(total == k * (int) (kS1.size() - kS2.size()));
+
+    std::vector<uint64_t> mB_actual;
+    std::vector<uint64_t> mA_actual;
+    assert(subtracted->decode(&mB_actual, &mA_actual));
+    checkDifference(mB_actual, mA_actual);
+  }
+  // Random differences near the peeling threshold, where mixed cells
+  // often look pure, terminate and never report a wrong success.
+  std::mt19937_64 rng(7);
+  for (uint32_t fp_bits : {0, 4}) {
+    for (int t = 0; t < 300; t++) {
+      std::vector<uint64_t> onlyA;
+      std::vector<uint64_t> onlyB;
+      for (int i = 0; i < 100; i++) {
+        onlyA.push_back(rng());
+        onlyB.push_back(rng());
+      }
+      CompactInvBloom a(200, k, 1.1, fp_bits);
+      CompactInvBloom b(200, k, 1.1, fp_bits);
+      a.encode(onlyA);
+      b.encode(onlyB);
+      a.subtract(b, &a);
+      std::vector<uint64_t> mB_actual;
+      std::vector<uint64_t> mA_actual;
+      if (a.decode(&mB_actual, &mA_actual)) {
+        std::sort(mB_actual.begin(), mB_actual.end());
+        std::sort(mA_actual.begin(), mA_actual.end());
+        std::sort(onlyA.begin(), onlyA.end());
+        std::sort(onlyB.begin(), onlyB.end());
+        assert(mB_actual == onlyA && mA_actual == onlyB);
+      }
+    }
+  }
+  CompactInvBloom* other = new CompactInvBloom(d, k, 1.5, 4);
+  assert(!compact->subtract(*other, compact));
+  fprintf(stdout, "passed testCompactInvBloom\n");
+}
+
+void testStreamingDecode() {
+  int d = 10;
+  int k = 3;
+  InvBloom* ibf1 = new InvBloom(d, k);
+  ibf1->encode(kS1);
+  InvBloom* ibf2 = new InvBloom(d, k);
+  ibf2->encode(kS2);
+  InvBloom* subtracted = new InvBloom(d, k);
+  ibf1->subtract(*ibf2, subtracted);
+
+  std::vector<uint64_t> mB_actual;
+  std::vector<uint64_t> mA_actual;
+  int calls = 0;
+  bool cancel = false;
+  DecodeSink sink = [&](uint64_t key, int side) {
+    calls++;
+    if (side > 0) {
+      mB_actual.push_back(key);
+    } else {
+      mA_actual.push_back(key);
+    }
+    return !cancel;
+  };
+
+  // Stops after two keys when the budget runs out, then resumes.
+  DecodeState state;
+  assert(subtracted->decode(sink, &state, DecodeBudget{2, 0}) == kDecodeBudgetExhausted);
+  assert(calls == 2);
+  // Cancelling from the sink stops right after that key.
+  cancel = true;
+  assert(subtracted->decode(sink, &state) == kDecodeCancelled);
+  assert(calls == 3);
+  cancel = false;
+  assert(subtracted->decode(sink, &state) == kDecodeSuccess);
+  assert(state.nonzero == 0);
+  checkDifference(mB_actual, mA_actual);
+
+  // A peel budget equal to the number of keys ends in success, not
+  // exhaustion, even though stale pure candidates remain.
+  ibf1->subtract(*ibf2, subtracted);
+  DecodeState exact_state;
+  int keys = kS1MinusS2.size() + kS2MinusS1.size();
+  assert(subtracted->decode(sink, &exact_state, DecodeBudget{(uint64_t) keys, 0}) \
+         == kDecodeSuccess);
+
+  // A time budget too small for any work still recovers at least one
+  // key per call, so repeated calls finish the decode.
+  std::vector<uint64_t> big_set;
+  for (uint64_t i = 1; i <= 20000; i++) { big_set.push_back(i * 7919); }
+  InvBloom* big = new InvBloom(big_set.size(), k);
+  big->encode(big_set);
+  DecodeState big_state;
+  int big_keys = 0;
+  DecodeSink count_sink = [&](uint64_t key, int side) {
+    big_keys++;
+    return true;
+  };
+  DecodeStatus status = kDecodeBudgetExhausted;
+  int big_calls = 0;
+  while (status == kDecodeBudgetExhausted) {
+    int before = big_keys;
+    status = big->decode(count_sink, &big_state, DecodeBudget{0, 1e-9});
+    assert(big_keys > before);
+    big_calls++;
+  }
+  assert(status == kDecodeSuccess);
+  assert(big_keys == (int) big_set.size());
+  assert(big_calls > 1);
+
+  // A difference too large for the table fails with cells left over.
+  InvBloom* small = new InvBloom(2, k);
+  small->encode(kS1);
+  DecodeState small_state;
+  assert(small->decode(sink, &small_state) == kDecodeFailure);
+  assert(small_state.nonzero > 0);
+  fprintf(stdout, "passed testStreamingDecode\n");
+}
+
 int main() {
   // Things I haven't tested: # elements >> size of filter
   //                          other edge cases
@@ -169,4 +676,12 @@ int main() {
   testEncodeDecode();
   testContains();
   testSubtract();
+  testTuneParams();
+  testFold();
+  testJointDecode();
+  testEpochWindow();
+  testFixedInvBloom();
+  testDeltaSync();
+  testCompactInvBloom();
+  testStreamingDecode();
 }
@@ -0,0 +1,145 @@
+#include "compact_bloom_filter.h"
+#include "bloom_filter.h"
+#include <cmath>
+#include <iostream>
+
+// Constants
+const CompactIbfCell kDefaultCompactCell = {0, 0};
+const uint32_t kMaxFpBits = 16;
+
+CompactInvBloom::CompactInvBloom(uint32_t d, uint32_t k, float alpha, uint32_t fp_bits) {
+  this->n = (uint32_t) ceil(d*alpha);
+  this->k = k;
+  this->fp_bits = fp_bits > kMaxFpBits ? kMaxFpBits : fp_bits;
+  this->table.resize(n, kDefaultCompactCell);
+}
+
+void CompactInvBloom::insert(const uint64_t elt) {
+  int idxs[this->k];
+  uint32_t fp = encodeHash(elt, idxs);
+  for (int j : idxs) {
+    update(j, elt, 1, fp);
+  }
+}
+
+void CompactInvBloom::encode(const std::vector<uint64_t> &set) {
+  for (uint64_t s_i : set) {
+    insert(s_i);
+  }
+}
+
+bool CompactInvBloom::subtract(const CompactInvBloom &other, CompactInvBloom *result) {
+  if (other.k != this->k || result->k != this->k || \
+      other.n != this->n || result->n != this->n) {
+    std::cerr << "this IBF, other, and result must all be initialized with same n and k\n";
+    return false;
+  }
+  if (other.fp_bits != this->fp_bits || result->fp_bits != this->fp_bits) {
+    std::cerr << "this IBF, other, and result must all use the same fp_bits\n";
+    return false;
+  }
+  // Counts subtract modulo 2^32 in the low bits; the fingerprint bits
+  // XOR. Handle them separately so borrows cannot leak across.
+  uint32_t count_mask = this->fp_bits ? (1u << (32 - this->fp_bits)) - 1 : ~0u;
+  for (int i = 0; i < this->n; i++) {
+    uint32_t a = this->table[i].meta;
+    uint32_t b = other.table[i].meta;
+    result->table[i].idSum = this->table[i].idSum ^ other.table[i].idSum;
+    result->table[i].meta = ((a - b) & count_mask) | ((a ^ b) & ~count_mask);
+  }
+  return true;
+}
+
+bool CompactInvBloom::decode(std::vector<uint64_t> *missingB, std::vector<uint64_t> *missingA) {
+  std::vector<int> pure_idxs;
+  for (int i = 0; i < this->n; i++) {
+    if (isPure(i)) { pure_idxs.push_back(i); }
+  }
+
+  int idxs[this->k];
+  // Each genuine peel empties its pure cell for good, so a successful
+  // decode peels at most n keys. A mixed cell whose idSum happens to
+  // hash to it can pass isPure; peeling it and the -idSum it leaves
+  // behind restores the cell, so cap the peels to stop that cycle.
+  uint32_t peels = 0;
+  while (pure_idxs.size() > 0) {
+    int i = pure_idxs.back();
+    pure_idxs.pop_back();
+    // Confirm elt at i is still pure.
+    if (!isPure(i)) { continue; }
+    if (++peels > this->n) { return false; }
+    int c = count(i);
+    uint64_t ids = this->table[i].idSum;
+    if (c > 0) {
+      missingB->push_back(ids);
+    } else {
+      missingA->push_back(ids);
+    }
+    uint32_t fp = encodeHash(ids, idxs);
+    for (int j : idxs) {
+      update(j, ids, -c, fp);
+      if (isPure(j)) { pure_idxs.push_back(j); }
+    }
+  }
+
+  // No pure indices remain; check that all fields in IBF are 0.
+  for (int i = 0; i < this->n; i++) {
+    if (this->table[i].meta != 0) { return false; }
+    if (this->table[i].idSum != 0) { return false; }
+  }
+  return true;
+}
+
+int CompactInvBloom::count(int idx) {
+  // Sign-extend the low (32 - fp_bits) bits.
+  return ((int32_t) (this->table[idx].meta << this->fp_bits)) >> this->fp_bits;
+}
+
+uint32_t CompactInvBloom::encodeHash(uint64_t elt, int indices[]) {
+  std::size_t prev_hash = InvBloom::indexHash(elt, 0);
+  // Take the fingerprint from the top bits of the first hash; the
+  // index only depends on it modulo n.
+  uint32_t fp = 0;
+  if (this->fp_bits) {
+    fp = (uint32_t) ((uint64_t) prev_hash >> (64 - this->fp_bits));
+  }
+  int count = 0;
+  while (count < this->k) {
+    int idx = prev_hash % this->n;
+    bool distinct = true;
+    for (int i = 0; i < count; i++) {
+      if (indices[i] == idx) { distinct = false; }
+    }
+    if (distinct) { indices[count++] = idx; }
+    prev_hash = InvBloom::nextIndexHash(prev_hash);
+  }
+  return fp;
+}
+
+bool CompactInvBloom::isPure(int idx) {
+  int c = count(idx);
+  if (c != 1 and c != -1) { return false; }
+  int idxs[this->k];
+  uint64_t ids = this->table[idx].idSum;
+  uint32_t fp = encodeHash(ids, idxs);
+  if (this->fp_bits && fp != this->table[idx].meta >> (32 - this->fp_bits)) {
+    return false;
+  }
+  for (int j : idxs) {
+    if (j == idx) { return true; }
+  }
+  return false;
+}
+
+void CompactInvBloom::update(int idx, uint64_t elt, int c, uint32_t fp) {
+  uint32_t meta = this->table[idx].meta;
+  if (this->fp_bits) {
+    uint32_t count_mask = (1u << (32 - this->fp_bits)) - 1;
+    meta = ((meta + (uint32_t) c) & count_mask) | \
+           ((meta & ~count_mask) ^ (fp << (32 - this->fp_bits)));
+  } else {
+    meta += (uint32_t) c;
+  }
+  this->table[idx].meta = meta;
+  this->table[idx].idSum ^= elt;
+}
@@ -0,0 +1,70 @@
+#ifndef COMPACT_BLOOM_FILTER_H
+#define COMPACT_BLOOM_FILTER_H
+
+#include <stdint.h>
+#include <vector>
+
+// Cell without a hashSum: 12 bytes instead of IbfCell's 24. Packing
+// leaves idSum only 4-byte aligned in every other cell, so copy it
+// out by value; never bind a reference or pointer to it.
+#pragma pack(push, 4)
+struct CompactIbfCell {
+  uint64_t idSum;
+  // Low (32 - fp_bits) bits: count, two's complement. High fp_bits
+  // bits: XOR of the fingerprints of the cell's elements.
+  uint32_t meta;
+};
+#pragma pack(pop)
+
+// Invertible bloom filter that validates pure cells without a
+// checksum: a cell with count +-1 is pure only if the candidate key
+// idSum hashes to that cell (and, with fp_bits > 0, its fingerprint
+// matches). Uses the same cell indices as a classic InvBloom with
+// seed 0, but cells are not interchangeable since the fields differ.
+class CompactInvBloom {
+  public:
+    uint32_t n; // number of cells; set to d*alpha
+    uint32_t k; // number of hash functions
+    uint32_t fp_bits; // fingerprint bits packed into meta (0 to 16)
+    std::vector<CompactIbfCell> table; // array of cells
+
+    // Constructor: takes desired number of cells and # hash fns, as
+    // InvBloom. fp_bits > 16 is clamped to 16 so counts keep at
+    // least 16 bits.
+    CompactInvBloom(uint32_t d, uint32_t k, float alpha=1.5, uint32_t fp_bits=0);
+
+    // Add a single element / every element of set to this IBF.
+    void insert(const uint64_t elt);
+    void encode(const std::vector<uint64_t> &set);
+
+    // Subtract IBF "other" from this IBF and store the result in
+    // result (which may be this). All three must share n, k and
+    // fp_bits.
+    bool subtract(const CompactInvBloom &other, CompactInvBloom *result);
+
+    // Decode this IBF; same contract as InvBloom::decode. Without a
+    // checksum a mixed cell can look pure, so missingB and missingA
+    // may hold bogus keys when this returns false.
+    bool decode(std::vector<uint64_t> *missingB, std::vector<uint64_t> *missingA);
+
+    // Count stored in cell idx.
+    int count(int idx);
+
+    // public only for testing and benchmarking purposes
+    // Populate "indices" (size of array is k) with the same indices
+    // InvBloom::encodeHash computes for seed 0, and return the
+    // fingerprint of elt (0 if fp_bits is 0).
+    uint32_t encodeHash(uint64_t elt, int indices[]);
+
+    // Return true if this index is pure; false otherwise
+    // pure: count = 1 or -1, idx is one of idSum's indices and the
+    // fingerprint of idSum matches.
+    bool isPure(int idx);
+
+  private:
+    // Add c to the count of cell idx and XOR elt and fp into it.
+    // Keys are taken by value throughout since idSum may be misaligned.
+    void update(int idx, uint64_t elt, int c, uint32_t fp);
+};
+
+#endif // COMPACT_BLOOM_FILTER_H
@@ -0,0 +1,59 @@
+#include "epoch_bloom_filter.h"
+#include <assert.h>
+#include <iostream>
+
+EpochInvBloom::EpochInvBloom(uint32_t num_epochs, uint32_t d, uint32_t k,
+                             float alpha, uint32_t seed)
+    : completed(d, k, alpha, 1, 0, seed) {
+  // Every epoch maps to slot epoch % num_epochs.
+  assert(num_epochs >= 1);
+  this->num_epochs = num_epochs;
+  this->current_epoch = 0;
+  this->epochs.resize(num_epochs, this->completed);
+}
+
+void EpochInvBloom::insert(const uint64_t elt) {
+  this->epochs[this->current_epoch % this->num_epochs].insert(elt);
+}
+
+void EpochInvBloom::encode(const std::vector<uint64_t> &set) {
+  this->epochs[this->current_epoch % this->num_epochs].encode(set);
+}
+
+// Close the current epoch and start the next one, expiring the
+// oldest epoch once the ring is full.
+void EpochInvBloom::advanceEpoch() {
+  InvBloom &closed = this->epochs[this->current_epoch % this->num_epochs];
+  this->completed.add(closed, &this->completed);
+  this->current_epoch++;
+  InvBloom &next = this->epochs[this->current_epoch % this->num_epochs];
+  if (this->current_epoch >= this->num_epochs) {
+    // next still holds epoch current_epoch - num_epochs, which just
+    // fell out of the window.
+    this->completed.subtract(next, &this->completed);
+  }
+  next.clear();
+}
+
+uint64_t EpochInvBloom::oldestEpoch() {
+  if (this->current_epoch < this->num_epochs) { return 0; }
+  return this->current_epoch - this->num_epochs + 1;
+}
+
+// Store the merge of epochs first..last (inclusive) in result.
+bool EpochInvBloom::window(uint64_t first, uint64_t last, InvBloom *result) {
+  if (first > last || first < oldestEpoch() || last > this->current_epoch) {
+    std::cerr << "epoch range [" << first << ", " << last << "] is not in the window\n";
+    return false;
+  }
+  InvBloom &current = this->epochs[this->current_epoch % this->num_epochs];
+  if (first == oldestEpoch() && last == this->current_epoch) {
+    *result = this->completed;
+    return result->add(current, result);
+  }
+  *result = this->epochs[first % this->num_epochs];
+  for (uint64_t e = first + 1; e <= last; e++) {
+    if (!result->add(this->epochs[e % this->num_epochs], result)) { return false; }
+  }
+  return true;
+}
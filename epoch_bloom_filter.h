@@ -0,0 +1,50 @@
+#ifndef EPOCH_BLOOM_FILTER_H
+#define EPOCH_BLOOM_FILTER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "bloom_filter.h"
+
+// Ring of per-epoch IBFs over the last num_epochs epochs. Inserts go
+// to the current epoch; advancing drops the oldest epoch, so the
+// window sketch only ever covers recent data. Replicas that want to
+// reconcile a window must advance their epochs in step and use the
+// same d, k, alpha and seed.
+class EpochInvBloom {
+  public:
+    uint32_t num_epochs; // number of live epochs (window length)
+    uint64_t current_epoch; // epoch receiving inserts; starts at 0
+
+    // Constructor: every epoch is an InvBloom(d, k, alpha) with the
+    // given seed, so d should be sized for the window difference.
+    // Precondition: num_epochs >= 1 (asserted).
+    EpochInvBloom(uint32_t num_epochs, uint32_t d, uint32_t k,
+                  float alpha=1.5, uint32_t seed=0);
+
+    // Add elt / every element of set to the current epoch.
+    void insert(const uint64_t elt);
+    void encode(const std::vector<uint64_t> &set);
+
+    // Close the current epoch and start the next one. Once the ring
+    // is full the oldest epoch expires: it is subtracted out of the
+    // running sketch of completed epochs and its slot is reused.
+    void advanceEpoch();
+
+    // Oldest epoch still in the window.
+    uint64_t oldestEpoch();
+
+    // Store the XOR/add merge of epochs first..last (inclusive) in
+    // result, which is overwritten. The full window (oldestEpoch() to
+    // current_epoch) costs one merge thanks to the running sketch.
+    // Returns false if the range is empty or not in the window.
+    bool window(uint64_t first, uint64_t last, InvBloom *result);
+
+  private:
+    // Sketch of epoch e lives in epochs[e % num_epochs].
+    std::vector<InvBloom> epochs;
+    // Sum of every live epoch except the current one.
+    InvBloom completed;
+};
+
+#endif // EPOCH_BLOOM_FILTER_H
@@ -0,0 +1,149 @@
+#ifndef FIXED_BLOOM_FILTER_H
+#define FIXED_BLOOM_FILTER_H
+
+#include <stdint.h>
+#include <array>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#include "bloom_filter.h"
+
+// Invertible bloom filter with N cells and K hash functions fixed at
+// compile time, for tiny sketches embedded in messages. The table is
+// a std::array, so the type is trivially copyable and can be memcpy'd
+// into and out of a buffer. Cells are laid out exactly like an
+// InvBloom with n = N, k = K, seed 0 and no folding, so the two types
+// can be converted into each other and subtracted/decoded together.
+template <uint32_t N, uint32_t K>
+class FixedInvBloom {
+  static_assert(K >= 1 && K <= N, "FixedInvBloom needs 1 <= K <= N");
+
+  public:
+    std::array<IbfCell, N> table; // array of cells
+
+    FixedInvBloom() { clear(); }
+
+    // Reduce a hash to a cell index. N is a compile-time constant, so
+    // this is a mask for power-of-two N and a constant modulo
+    // otherwise; either way it matches InvBloom's hash % n.
+    static constexpr uint32_t reduce(std::size_t hash) {
+      return (N & (N - 1)) == 0 ? hash & (N - 1) : hash % N;
+    }
+
+    // Populate "indices" with the K distinct cell indices of elt (not
+    // sorted, unlike InvBloom::encodeHash; order does not matter).
+    static void encodeHash(const uint64_t &elt, uint32_t (&indices)[K]) {
+      std::size_t prev_hash = InvBloom::indexHash(elt, 0);
+      uint32_t count = 0;
+      while (count < K) {
+        uint32_t idx = reduce(prev_hash);
+        bool distinct = true;
+        for (uint32_t i = 0; i < count; i++) {
+          if (indices[i] == idx) { distinct = false; }
+        }
+        if (distinct) { indices[count++] = idx; }
+        prev_hash = InvBloom::nextIndexHash(prev_hash);
+      }
+    }
+
+    void clear() {
+      for (uint32_t i = 0; i < N; i++) { this->table[i] = IbfCell{0, 0, 0}; }
+    }
+
+    // Add a single element / every element of set to this IBF.
+    void insert(const uint64_t elt) {
+      uint32_t idxs[K];
+      encodeHash(elt, idxs);
+      uint32_t hs = InvBloom::checksumHash(elt);
+      for (uint32_t j : idxs) {
+        this->table[j].idSum ^= elt;
+        this->table[j].hashSum ^= hs;
+        this->table[j].count++;
+      }
+    }
+
+    void encode(const std::vector<uint64_t> &set) {
+      for (uint64_t s_i : set) { insert(s_i); }
+    }
+
+    // Subtract IBF "other" from this IBF and store the result in
+    // result (which may be this).
+    void subtract(const FixedInvBloom &other, FixedInvBloom *result) const {
+      for (uint32_t i = 0; i < N; i++) {
+        result->table[i].idSum = this->table[i].idSum ^ other.table[i].idSum;
+        result->table[i].hashSum = this->table[i].hashSum ^ other.table[i].hashSum;
+        result->table[i].count = this->table[i].count - other.table[i].count;
+      }
+    }
+
+    // Decode this IBF; same contract as InvBloom::decode. Peels by
+    // rescanning the table instead of keeping a stack of pure cells,
+    // which is cheap for small N and needs no allocation. Returns
+    // false on a cell whose key does not map back to it, so a corrupt
+    // message cannot make it loop.
+    bool decode(std::vector<uint64_t> *missingB, std::vector<uint64_t> *missingA) {
+      bool progress = true;
+      while (progress) {
+        progress = false;
+        for (uint32_t i = 0; i < N; i++) {
+          if (!isPure(i)) { continue; }
+          int c = this->table[i].count;
+          uint64_t ids = this->table[i].idSum;
+          if (c > 0) {
+            missingB->push_back(ids);
+          } else {
+            missingA->push_back(ids);
+          }
+          uint32_t idxs[K];
+          encodeHash(ids, idxs);
+          uint32_t hs = InvBloom::checksumHash(ids);
+          for (uint32_t j : idxs) {
+            this->table[j].count -= c;
+            this->table[j].hashSum ^= hs;
+            this->table[j].idSum ^= ids;
+          }
+          // A cell that passed the checksum but whose key does not
+          // hash to it stays pure forever; treat it as a failure.
+          if (this->table[i].count != 0 || this->table[i].idSum != 0) {
+            return false;
+          }
+          progress = true;
+        }
+      }
+      for (uint32_t i = 0; i < N; i++) {
+        if (this->table[i].count != 0) { return false; }
+        if (this->table[i].hashSum != 0) { return false; }
+        if (this->table[i].idSum != 0) { return false; }
+      }
+      return true;
+    }
+
+    // Copy this IBF into a dynamic one; result is resized to match.
+    void toInvBloom(InvBloom *result) const {
+      *result = InvBloom(N, K, 1.0);
+      result->table.assign(this->table.begin(), this->table.end());
+    }
+
+    // Load the cells of a dynamic IBF. Returns false unless other
+    // has the same layout (n = N, k = K, seed 0, not foldable).
+    bool fromInvBloom(const InvBloom &other) {
+      if (other.n != N || other.k != K || other.partitioned || other.seed != 0) {
+        std::cerr << "InvBloom must have n = " << N << ", k = " << K
+                  << ", seed 0 and no folding\n";
+        return false;
+      }
+      for (uint32_t i = 0; i < N; i++) { this->table[i] = other.table[i]; }
+      return true;
+    }
+
+  private:
+    // pure: count = 1 or -1 and checksumHash(idSum) = hashSum
+    bool isPure(uint32_t idx) const {
+      int c = this->table[idx].count;
+      if (c != 1 && c != -1) { return false; }
+      return this->table[idx].hashSum == InvBloom::checksumHash(this->table[idx].idSum);
+    }
+};
+
+#endif // FIXED_BLOOM_FILTER_H
@@ -0,0 +1,63 @@
+#include "ibf_tuner.h"
+#include "ibf_tuner_tables.h"
+#include <cmath>
+
+// Cells needed for kTunerD[di] elements with k = kTunerMinK + ki at
+// failure probability p. Between sampled probabilities the cell count
+// is interpolated linearly in log(p); below the smallest sampled
+// probability the last two columns are extrapolated the same way.
+static double tabulatedCells(uint32_t ki, uint32_t di, double p) {
+  const uint32_t *cells = kTunerCells[ki][di];
+  if (p >= kTunerP[0]) { return cells[0]; }
+  uint32_t hi = 1;
+  while (hi < kTunerNumP - 1 && p < kTunerP[hi]) { hi++; }
+  double t = log(p / kTunerP[hi - 1]) / log(kTunerP[hi] / kTunerP[hi - 1]);
+  double c = cells[hi - 1] + t * ((double) cells[hi] - cells[hi - 1]);
+  // Never ask for fewer cells than a sampled, less strict target.
+  return fmax(c, cells[hi - 1]);
+}
+
+// Cells needed for d elements with k = kTunerMinK + ki. Between
+// sampled differences the cell count is interpolated linearly, so it
+// never decreases as d grows. Beyond the last sample the last
+// cells-per-element ratio is scaled up to d, floored at the
+// asymptotic peeling threshold.
+static uint32_t cellsFor(uint32_t ki, uint32_t d, double p) {
+  uint32_t di = 0;
+  while (di < kTunerNumD - 1 && kTunerD[di + 1] <= d) { di++; }
+  double cells;
+  if (di < kTunerNumD - 1) {
+    double lo = tabulatedCells(ki, di, p);
+    double hi = tabulatedCells(ki, di + 1, p);
+    double t = (double) (d - kTunerD[di]) / (kTunerD[di + 1] - kTunerD[di]);
+    cells = lo + t * (hi - lo);
+  } else {
+    double ratio = tabulatedCells(ki, di, p) / kTunerD[di];
+    cells = fmax(ratio, kPeelThreshold[ki]) * d;
+  }
+  uint32_t n = (uint32_t) ceil(cells - 1e-9);
+  uint32_t k = kTunerMinK + ki;
+  return n < k ? k : n;
+}
+
+IbfParams tuneParams(uint32_t d, double failure_prob) {
+  if (d == 0) { d = 1; }
+  // log(p) below must stay finite; also catches NaN.
+  if (!(failure_prob >= kTunerMinP)) { failure_prob = kTunerMinP; }
+  if (failure_prob > 1) { failure_prob = 1; }
+  IbfParams best = {d, 0, 0, 0};
+  for (uint32_t ki = 0; ki < kTunerNumK; ki++) {
+    uint32_t n = cellsFor(ki, d, failure_prob);
+    if (best.k == 0 || n < best.n) {
+      best.k = kTunerMinK + ki;
+      best.n = n;
+    }
+  }
+  // InvBloom sizes its table as ceil(d*alpha) in float arithmetic;
+  // nudge alpha so that this reproduces n exactly.
+  float alpha = (float) best.n / d;
+  while (ceil(d*alpha) > best.n) { alpha = nextafterf(alpha, 0); }
+  while (ceil(d*alpha) < best.n) { alpha = nextafterf(alpha, 2*alpha); }
+  best.alpha = alpha;
+  return best;
+}
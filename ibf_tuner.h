@@ -0,0 +1,32 @@
+#ifndef IBF_TUNER_H
+#define IBF_TUNER_H
+
+#include <stdint.h>
+
+// Range of hash function counts covered by the tuner tables.
+const uint32_t kTunerMinK = 3;
+const uint32_t kTunerNumK = 4;
+
+// Strictest failure probability the tuner targets; smaller (or
+// nonpositive) targets are clamped to it.
+const double kTunerMinP = 1e-12;
+
+// IBF parameters picked by tuneParams.
+struct IbfParams {
+  uint32_t d;  // difference size to construct with (d clamped to >= 1)
+  uint32_t k;  // number of hash functions
+  float alpha; // cells per expected difference element
+  uint32_t n;  // resulting number of cells, ceil(d*alpha)
+};
+
+// Pick k, alpha and table size for an IBF that should decode a
+// set difference of (up to) d elements with failure probability at
+// most failure_prob. Uses the precomputed tables in
+// ibf_tuner_tables.h (regenerate with ibfsim). Returns the k that
+// needs the fewest cells; ties go to the smaller k. failure_prob
+// should lie in (0, 1); it is clamped to [kTunerMinP, 1]. d = 0 is
+// tuned as d = 1, so construct with the returned d, not the one
+// passed in: InvBloom ibf(p.d, p.k, p.alpha);
+IbfParams tuneParams(uint32_t d, double failure_prob);
+
+#endif // IBF_TUNER_H
@@ -0,0 +1,170 @@
+// Simulation tool that regenerates ibf_tuner_tables.h.
+//
+// For every k, expected difference d and target failure probability
+// in the tuner's grid, binary search for the smallest number of cells
+// n such that peeling d random elements out of an n-cell IBF fails
+// with probability at most the target. Each element is mapped to k
+// distinct cells drawn uniformly at random, which is the model that
+// InvBloom::encodeHash approximates.
+//
+// Usage: ibfsim [trial scale] > ibf_tuner_tables.h
+// The number of trials for target p is (trial scale)/p (default 30).
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "ibf_tuner.h"
+
+// Asymptotic peeling thresholds (cells per element) for k = 3..6,
+// i.e. 1/c*_k where c*_k is the 2-core threshold of a random
+// k-uniform hypergraph.
+const double kThresholds[] = {1.222, 1.295, 1.425, 1.570};
+const uint32_t kDs[] = {1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96,
+                        128, 192, 256, 384, 512, 768, 1024};
+const double kProbs[] = {1e-1, 1e-2, 1e-3};
+
+class PeelSim {
+  public:
+    PeelSim(uint32_t k, uint32_t d, uint32_t n) : k(k), d(d), n(n),
+      count(n), idSum(n), edges(d * k), rng(0x1bf) {}
+
+    // Returns true if one random IBF with d elements fully peels.
+    bool trial() {
+      std::fill(count.begin(), count.end(), 0);
+      std::fill(idSum.begin(), idSum.end(), 0);
+      std::uniform_int_distribution<uint32_t> cell(0, n - 1);
+      for (uint32_t e = 0; e < d; e++) {
+        uint32_t *idxs = &edges[e * k];
+        for (uint32_t j = 0; j < k; j++) {
+          uint32_t c;
+          bool distinct;
+          do {
+            c = cell(rng);
+            distinct = true;
+            for (uint32_t t = 0; t < j; t++) {
+              if (idxs[t] == c) { distinct = false; }
+            }
+          } while (!distinct);
+          idxs[j] = c;
+          count[c]++;
+          idSum[c] ^= e;
+        }
+      }
+      pure.clear();
+      for (uint32_t i = 0; i < n; i++) {
+        if (count[i] == 1) { pure.push_back(i); }
+      }
+      uint32_t peeled = 0;
+      while (pure.size() > 0) {
+        uint32_t i = pure.back();
+        pure.pop_back();
+        if (count[i] != 1) { continue; }
+        uint32_t e = idSum[i];
+        peeled++;
+        for (uint32_t j = 0; j < k; j++) {
+          uint32_t c = edges[e * k + j];
+          count[c]--;
+          idSum[c] ^= e;
+          if (count[c] == 1) { pure.push_back(c); }
+        }
+      }
+      return peeled == d;
+    }
+
+    // Returns true if the failure rate over "trials" runs is at most
+    // p. Stops as soon as the failure budget is exceeded.
+    bool meets(double p, uint32_t trials) {
+      uint32_t budget = (uint32_t) floor(p * trials);
+      uint32_t failures = 0;
+      for (uint32_t t = 0; t < trials; t++) {
+        if (!trial()) {
+          failures++;
+          if (failures > budget) { return false; }
+        }
+      }
+      return true;
+    }
+
+  private:
+    uint32_t k;
+    uint32_t d;
+    uint32_t n;
+    std::vector<uint32_t> count;
+    std::vector<uint32_t> idSum;
+    std::vector<uint32_t> edges;
+    std::vector<uint32_t> pure;
+    std::mt19937_64 rng;
+};
+
+// Smallest n for which d elements peel with failure rate <= p.
+uint32_t minCells(uint32_t k, uint32_t d, double p, uint32_t trials) {
+  uint32_t lo = k;
+  uint32_t hi = k + (uint32_t) ceil(2 * d);
+  while (!PeelSim(k, d, hi).meets(p, trials)) { hi *= 2; }
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (PeelSim(k, d, mid).meets(p, trials)) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+int main(int argc, char **argv) {
+  double scale = 30;
+  if (argc > 1) { scale = atof(argv[1]); }
+
+  printf("// Generated by ibfsim (ibf_tuner_sim.cpp); do not edit by hand.\n");
+  printf("// Trial scale: %g trials per 1/p.\n", scale);
+  printf("#ifndef IBF_TUNER_TABLES_H\n#define IBF_TUNER_TABLES_H\n\n");
+  printf("#include \"ibf_tuner.h\"\n\n");
+  printf("const uint32_t kTunerNumD = %lu;\n", sizeof(kDs) / sizeof(kDs[0]));
+  printf("const uint32_t kTunerNumP = %lu;\n\n", sizeof(kProbs) / sizeof(kProbs[0]));
+
+  printf("// Asymptotic peeling thresholds (cells per element), by k.\n");
+  printf("constexpr double kPeelThreshold[kTunerNumK] = {");
+  for (uint32_t i = 0; i < kTunerNumK; i++) {
+    printf("%s%.3f", i ? ", " : "", kThresholds[i]);
+  }
+  printf("};\n\n");
+
+  printf("// Expected differences at which the table was sampled.\n");
+  printf("constexpr uint32_t kTunerD[kTunerNumD] = {");
+  for (uint32_t i = 0; i < sizeof(kDs) / sizeof(kDs[0]); i++) {
+    printf("%s%u", i ? ", " : "", kDs[i]);
+  }
+  printf("};\n\n");
+
+  printf("// Target failure probabilities at which the table was sampled.\n");
+  printf("constexpr double kTunerP[kTunerNumP] = {");
+  for (uint32_t i = 0; i < sizeof(kProbs) / sizeof(kProbs[0]); i++) {
+    printf("%s%g", i ? ", " : "", kProbs[i]);
+  }
+  printf("};\n\n");
+
+  printf("// Smallest number of cells with decode failure rate <= kTunerP[p]\n");
+  printf("// for a difference of kTunerD[d] elements: kTunerCells[k][d][p].\n");
+  printf("constexpr uint32_t kTunerCells[kTunerNumK][kTunerNumD][kTunerNumP] = {\n");
+  for (uint32_t ki = 0; ki < kTunerNumK; ki++) {
+    uint32_t k = kTunerMinK + ki;
+    printf("  { // k = %u\n", k);
+    for (uint32_t di = 0; di < sizeof(kDs) / sizeof(kDs[0]); di++) {
+      printf("    {");
+      for (uint32_t pi = 0; pi < sizeof(kProbs) / sizeof(kProbs[0]); pi++) {
+        uint32_t trials = (uint32_t) ceil(scale / kProbs[pi]);
+        uint32_t n = minCells(k, kDs[di], kProbs[pi], trials);
+        printf("%s%u", pi ? ", " : "", n);
+        fflush(stdout);
+      }
+      printf("}, // d = %u\n", kDs[di]);
+    }
+    printf("  },\n");
+  }
+  printf("};\n\n#endif // IBF_TUNER_TABLES_H\n");
+}
@@ -0,0 +1,113 @@
+// Generated by ibfsim (ibf_tuner_sim.cpp); do not edit by hand.
+// Trial scale: 30 trials per 1/p.
+#ifndef IBF_TUNER_TABLES_H
+#define IBF_TUNER_TABLES_H
+
+#include "ibf_tuner.h"
+
+const uint32_t kTunerNumD = 20;
+const uint32_t kTunerNumP = 3;
+
+// Asymptotic peeling thresholds (cells per element), by k.
+constexpr double kPeelThreshold[kTunerNumK] = {1.222, 1.295, 1.425, 1.570};
+
+// Expected differences at which the table was sampled.
+constexpr uint32_t kTunerD[kTunerNumD] = {1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024};
+
+// Target failure probabilities at which the table was sampled.
+constexpr double kTunerP[kTunerNumP] = {0.1, 0.01, 0.001};
+
+// Smallest number of cells with decode failure rate <= kTunerP[p]
+// for a difference of kTunerD[d] elements: kTunerCells[k][d][p].
+constexpr uint32_t kTunerCells[kTunerNumK][kTunerNumD][kTunerNumP] = {
+  { // k = 3
+    {3, 3, 3}, // d = 1
+    {5, 10, 21}, // d = 2
+    {7, 13, 29}, // d = 3
+    {10, 17, 36}, // d = 4
+    {13, 24, 49}, // d = 6
+    {17, 28, 57}, // d = 8
+    {22, 38, 83}, // d = 12
+    {30, 45, 94}, // d = 16
+    {40, 65, 117}, // d = 24
+    {52, 75, 134}, // d = 32
+    {72, 93, 187}, // d = 48
+    {92, 115, 235}, // d = 64
+    {132, 153, 299}, // d = 96
+    {174, 193, 369}, // d = 128
+    {255, 272, 485}, // d = 192
+    {336, 354, 616}, // d = 256
+    {495, 514, 755}, // d = 384
+    {654, 675, 941}, // d = 512
+    {974, 998, 1131}, // d = 768
+    {1290, 1317, 1532}, // d = 1024
+  },
+  { // k = 4
+    {4, 4, 4}, // d = 1
+    {6, 9, 15}, // d = 2
+    {8, 12, 18}, // d = 3
+    {10, 14, 22}, // d = 4
+    {13, 18, 29}, // d = 6
+    {16, 22, 31}, // d = 8
+    {22, 28, 39}, // d = 12
+    {28, 33, 45}, // d = 16
+    {39, 45, 56}, // d = 24
+    {50, 56, 65}, // d = 32
+    {72, 78, 87}, // d = 48
+    {95, 101, 108}, // d = 64
+    {137, 145, 153}, // d = 96
+    {182, 189, 196}, // d = 128
+    {267, 276, 285}, // d = 192
+    {350, 364, 372}, // d = 256
+    {521, 534, 545}, // d = 384
+    {688, 706, 716}, // d = 512
+    {1024, 1045, 1058}, // d = 768
+    {1361, 1381, 1399}, // d = 1024
+  },
+  { // k = 5
+    {5, 5, 5}, // d = 1
+    {7, 9, 13}, // d = 2
+    {8, 12, 17}, // d = 3
+    {11, 13, 18}, // d = 4
+    {14, 17, 22}, // d = 6
+    {17, 21, 25}, // d = 8
+    {23, 27, 32}, // d = 12
+    {30, 34, 38}, // d = 16
+    {43, 47, 52}, // d = 24
+    {55, 60, 65}, // d = 32
+    {79, 85, 90}, // d = 48
+    {103, 109, 114}, // d = 64
+    {151, 158, 164}, // d = 96
+    {199, 207, 213}, // d = 128
+    {293, 304, 310}, // d = 192
+    {384, 396, 406}, // d = 256
+    {572, 585, 596}, // d = 384
+    {758, 772, 785}, // d = 512
+    {1127, 1148, 1161}, // d = 768
+    {1497, 1519, 1536}, // d = 1024
+  },
+  { // k = 6
+    {6, 6, 6}, // d = 1
+    {8, 9, 12}, // d = 2
+    {10, 12, 15}, // d = 3
+    {11, 14, 17}, // d = 4
+    {15, 18, 21}, // d = 6
+    {18, 22, 25}, // d = 8
+    {26, 30, 33}, // d = 12
+    {33, 37, 40}, // d = 16
+    {47, 52, 55}, // d = 24
+    {61, 65, 70}, // d = 32
+    {87, 92, 98}, // d = 48
+    {114, 120, 125}, // d = 64
+    {167, 174, 180}, // d = 96
+    {217, 227, 233}, // d = 128
+    {322, 333, 341}, // d = 192
+    {424, 437, 446}, // d = 256
+    {631, 644, 656}, // d = 384
+    {834, 851, 864}, // d = 512
+    {1242, 1262, 1278}, // d = 768
+    {1648, 1671, 1690}, // d = 1024
+  },
+};
+
+#endif // IBF_TUNER_TABLES_H